@@ -0,0 +1,203 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+// Compares the old cpprest DOM parse of /me/player/currently-playing with the
+// streaming TrackParser: wall time and heap bytes allocated per parse.
+
+#include "../include/TrackParser.h"
+#include <cpprest/json.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace {
+    std::atomic<uint64_t> allocatedBytes{0};
+    std::atomic<uint64_t> allocations{0};
+
+    const char* const MARKETS[] = {
+        "AD", "AE", "AG", "AL", "AM", "AO", "AR", "AT", "AU", "AZ", "BA", "BB", "BD", "BE", "BF", "BG",
+        "BH", "BI", "BJ", "BN", "BO", "BR", "BS", "BT", "BW", "BY", "BZ", "CA", "CD", "CG", "CH", "CI",
+        "CL", "CM", "CO", "CR", "CV", "CW", "CY", "CZ", "DE", "DJ", "DK", "DM", "DO", "DZ", "EC", "EE",
+        "EG", "ES", "ET", "FI", "FJ", "FM", "FR", "GA", "GB", "GD", "GE", "GH", "GM", "GN", "GQ", "GR",
+        "GT", "GW", "GY", "HK", "HN", "HR", "HT", "HU", "ID", "IE", "IL", "IN", "IQ", "IS", "IT", "JM",
+        "JO", "JP", "KE", "KG", "KH", "KI", "KM", "KN", "KR", "KW", "KZ", "LA", "LB", "LC", "LI", "LK",
+        "LR", "LS", "LT", "LU", "LV", "LY", "MA", "MC", "MD", "ME", "MG", "MH", "MK", "ML", "MN", "MO",
+        "MR", "MT", "MU", "MV", "MW", "MX", "MY", "MZ", "NA", "NE", "NG", "NI", "NL", "NO", "NP", "NR",
+        "NZ", "OM", "PA", "PE", "PG", "PH", "PK", "PL", "PS", "PT", "PW", "PY", "QA", "RO", "RS", "RW",
+        "SA", "SB", "SC", "SE", "SG", "SI", "SK", "SL", "SM", "SN", "SR", "ST", "SV", "SZ", "TD", "TG",
+        "TH", "TJ", "TL", "TN", "TO", "TR", "TT", "TV", "TW", "TZ", "UA", "UG", "US", "UY", "UZ", "VC",
+        "VE", "VN", "VU", "WS", "XK", "ZA", "ZM", "ZW"
+    };
+
+    std::string markets() {
+        std::string out = "[";
+        for (const char* market : MARKETS) {
+            if (out.size() > 1) out += ",";
+            out += "\"" + std::string(market) + "\"";
+        }
+        return out + "]";
+    }
+
+    std::string artist(const std::string& id, const std::string& name) {
+        return R"({"external_urls":{"spotify":"https://open.spotify.com/artist/)" + id + R"("},)"
+               R"("href":"https://api.spotify.com/v1/artists/)" + id + R"(","id":")" + id + R"(",)"
+               R"("name":")" + name + R"(","type":"artist","uri":"spotify:artist:)" + id + R"("})";
+    }
+
+    std::string image(int size) {
+        return R"({"height":)" + std::to_string(size) +
+               R"(,"url":"https://i.scdn.co/image/ab67616d0000b273)" + std::to_string(size) +
+               R"(e8b066f70c206551210d902","width":)" + std::to_string(size) + "}";
+    }
+
+    // Shape and size of a real response: both market lists, three covers, two artists
+    std::string currentlyPlaying() {
+        const std::string artists = "[" + artist("0TnOYISbd1XYRBk9myaseg", "Pitbull") + "," +
+                                    artist("7bXgB6jMjp9ATFy66eO08Z", "Chris Brown") + "]";
+
+        return R"({"timestamp":1760645000000,"context":{"external_urls":{"spotify":"https://open.spotify.com/playlist/37i9dQZF1DXcBWIGoYBM5M"},)"
+               R"("href":"https://api.spotify.com/v1/playlists/37i9dQZF1DXcBWIGoYBM5M","type":"playlist",)"
+               R"("uri":"spotify:playlist:37i9dQZF1DXcBWIGoYBM5M"},"progress_ms":84213,"item":{"album":{)"
+               R"("album_type":"album","artists":)" + artists + R"(,"available_markets":)" + markets() +
+               R"(,"external_urls":{"spotify":"https://open.spotify.com/album/4aawyAB9vmqN3uQ7FjRGTy"},)"
+               R"("href":"https://api.spotify.com/v1/albums/4aawyAB9vmqN3uQ7FjRGTy","id":"4aawyAB9vmqN3uQ7FjRGTy",)"
+               R"("images":[)" + image(640) + "," + image(300) + "," + image(64) +
+               R"(],"name":"Global Warming","release_date":"2012-11-16","release_date_precision":"day",)"
+               R"("total_tracks":18,"type":"album","uri":"spotify:album:4aawyAB9vmqN3uQ7FjRGTy"},)"
+               R"("artists":)" + artists + R"(,"available_markets":)" + markets() +
+               R"(,"disc_number":1,"duration_ms":207959,"explicit":false,"external_ids":{"isrc":"USRC11200933"},)"
+               R"("external_urls":{"spotify":"https://open.spotify.com/track/6DkXLzBQT7cwXmTyzQ6U0T"},)"
+               R"("href":"https://api.spotify.com/v1/tracks/6DkXLzBQT7cwXmTyzQ6U0T","id":"6DkXLzBQT7cwXmTyzQ6U0T",)"
+               R"json("is_local":false,"name":"International Love (feat. Chris Brown)","popularity":74,)json"
+               R"("preview_url":null,"track_number":5,"type":"track","uri":"spotify:track:6DkXLzBQT7cwXmTyzQ6U0T"},)"
+               R"("currently_playing_type":"track","actions":{"disallows":{"resuming":true}},"is_playing":true})";
+    }
+
+    // The extraction getCurrentTrack did before TrackParser, plus the timestamp
+    // TrackParser also reads, so both paths fill the same fields
+    bool parseDom(const std::string& body, SpotifyTrack& track) {
+        auto json = web::json::value::parse(body);
+
+        track.isPlaying = json["is_playing"].as_bool();
+        if (json.has_field("timestamp") && json["timestamp"].is_integer()) {
+            track.timestamp = json["timestamp"].as_number().to_int64();
+        }
+        if (json.has_field("progress_ms") && json["progress_ms"].is_integer()) {
+            track.progressMs = json["progress_ms"].as_integer();
+        }
+
+        auto item = json["item"];
+        if (item.has_field("id") && item["id"].is_string()) {
+            track.id = item["id"].as_string();
+        }
+        track.name = item["name"].as_string();
+
+        if (item.has_field("duration_ms") && item["duration_ms"].is_integer()) {
+            track.durationMs = item["duration_ms"].as_integer();
+        }
+
+        if (auto artists = item["artists"]; artists.size() > 0) {
+            track.artist = artists[0]["name"].as_string();
+            for (size_t i = 1; i < artists.size(); ++i) {
+                track.artist += ", " + artists[i]["name"].as_string();
+            }
+        }
+
+        if (auto images = item["album"]["images"]; images.size() > 0) {
+            track.imageUrl = images[0]["url"].as_string();
+        }
+        return true;
+    }
+
+    struct Result {
+        double nanosPerParse = 0;
+        double bytesPerParse = 0;
+        double allocationsPerParse = 0;
+    };
+
+    template<typename Parse>
+    Result measure(int iterations, Parse parse) {
+        // One untimed pass so lazily grown buffers are not charged to the loop
+        parse();
+
+        const uint64_t bytesBefore = allocatedBytes;
+        const uint64_t countBefore = allocations;
+        const auto started = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; ++i) {
+            if (!parse()) {
+                std::cerr << "Parse failed" << std::endl;
+                std::exit(1);
+            }
+        }
+
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+
+        Result result;
+        result.nanosPerParse = elapsed.count() / iterations;
+        result.bytesPerParse = static_cast<double>(allocatedBytes - bytesBefore) / iterations;
+        result.allocationsPerParse = static_cast<double>(allocations - countBefore) / iterations;
+        return result;
+    }
+
+    void report(const char* name, const Result& result) {
+        std::cout << std::left << std::setw(6) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << result.nanosPerParse / 1000.0 << " us/parse"
+                  << std::setw(12) << result.bytesPerParse << " B/parse"
+                  << std::setw(10) << result.allocationsPerParse << " allocs/parse" << std::endl;
+    }
+}
+
+void* operator new(std::size_t size) {
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char* argv[]) {
+    const int iterations = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 20000;
+    const std::string body = currentlyPlaying();
+
+    std::cout << "currently-playing payload: " << body.size() << " bytes, " << iterations << " iterations" << std::endl;
+
+    SpotifyTrack domTrack;
+    const Result dom = measure(iterations, [&]() {
+        domTrack = SpotifyTrack();
+        return parseDom(body, domTrack);
+    });
+
+    // The old code took the first (largest) cover; asking for 640 px selects the same one
+    TrackParser parser;
+    SpotifyTrack saxTrack;
+    const Result sax = measure(iterations, [&]() {
+        saxTrack = SpotifyTrack();
+        return parser.parseCurrentlyPlaying(body, saxTrack, 640);
+    });
+
+    report("dom", dom);
+    report("sax", sax);
+
+    if (domTrack.id != saxTrack.id || domTrack.name != saxTrack.name || domTrack.artist != saxTrack.artist ||
+        domTrack.imageUrl != saxTrack.imageUrl || domTrack.isPlaying != saxTrack.isPlaying ||
+        domTrack.progressMs != saxTrack.progressMs || domTrack.durationMs != saxTrack.durationMs ||
+        domTrack.timestamp != saxTrack.timestamp) {
+        std::cerr << "DOM and SAX results differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_ALBUMARTCACHE_H
+#define SPOTIFYOVERLAY_ALBUMARTCACHE_H
+
+#pragma once
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QPixmap>
+#include <QString>
+
+struct AlbumArtCacheStats {
+    quint64 memoryHits = 0;
+    quint64 memoryMisses = 0;
+    quint64 diskHits = 0;
+    quint64 diskMisses = 0;
+    qint64 diskBytes = 0;
+    int memoryEntries = 0;
+};
+
+// Finished (rounded, scaled) pixmaps in a memory LRU keyed by URL and device
+// pixel ratio, plus the downloaded image bytes on disk so covers survive
+// restarts. Disk files are named by the SHA-1 of the image URL; Spotify image
+// URLs already identify their content.
+// The pixmap calls belong to the GUI thread; the disk calls are made from the
+// AlbumArtPipeline worker so file IO never blocks painting.
+class AlbumArtCache {
+public:
+    explicit AlbumArtCache(int memoryEntries = 32, qint64 diskBytes = 32 * 1024 * 1024);
+
+    bool findPixmap(const QString& url, qreal devicePixelRatio, QPixmap& pixmap);
+    [[nodiscard]] bool containsPixmap(const QString& url, qreal devicePixelRatio) const;
+    void insertPixmap(const QString& url, const QPixmap& pixmap);
+
+    bool readBytes(const QString& url, QByteArray& data);
+    void writeBytes(const QString& url, const QByteArray& data);
+    void trimDisk();
+
+    void setLimits(int memoryEntries, qint64 diskBytes);
+    [[nodiscard]] AlbumArtCacheStats stats() const;
+
+private:
+    QCache<QString, QPixmap> memory_;
+    QString directory_;
+    QAtomicInteger<qint64> diskLimit_;
+    AlbumArtCacheStats stats_;
+
+    // Disk counters are written by the worker and read by stats()
+    mutable QMutex diskStatsMutex_;
+    AlbumArtCacheStats diskStats_;
+
+    [[nodiscard]] QString pathFor(const QString& url) const;
+    [[nodiscard]] static QString memoryKey(const QString& url, qreal devicePixelRatio);
+};
+
+#endif //SPOTIFYOVERLAY_ALBUMARTCACHE_H
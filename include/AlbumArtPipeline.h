@@ -0,0 +1,44 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_ALBUMARTPIPELINE_H
+#define SPOTIFYOVERLAY_ALBUMARTPIPELINE_H
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+class AlbumArtCache;
+
+// Reads and writes the disk cache, then decodes, downscales and rounds album
+// art on a single worker thread, so tasks run in submission order. The result
+// is a QImage so it can cross threads; the GUI thread turns it into a QPixmap.
+class AlbumArtPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AlbumArtPipeline(AlbumArtCache *cache, QObject *parent = nullptr);
+    ~AlbumArtPipeline() override;
+
+    // Emits finished() on a disk hit and diskMissed() otherwise
+    void load(const QString& url, int size, qreal devicePixelRatio, bool prefetch);
+    void store(const QString& url, const QByteArray& imageData, int size, qreal devicePixelRatio, bool decode);
+    void trimDisk();
+    static QImage render(const QByteArray& imageData, int size, qreal devicePixelRatio);
+
+signals:
+    void finished(const QString& url, const QImage& image);
+    void diskMissed(const QString& url, bool prefetch);
+
+private:
+    AlbumArtCache *cache_;
+    QThreadPool pool_;
+};
+
+#endif //SPOTIFYOVERLAY_ALBUMARTPIPELINE_H
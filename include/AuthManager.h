@@ -10,34 +10,52 @@
 #include <string>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include "Types.h"
 
 class AuthManager {
 public:
     using AuthCallback = std::function<void(const AuthTokens&)>;
+    using StateCallback = std::function<void(AuthState, const std::string&)>;
 
-    AuthManager(const std::string& clientId, const std::string& clientSecret);
+    AuthManager(const std::string& clientId, const std::string& clientSecret,
+                const std::string& accountsUrl = "https://accounts.spotify.com");
     ~AuthManager();
 
+    bool restoreSession();
     bool authenticate();
-    bool refreshTokens(const std::string& refreshToken);
-    [[nodiscard]] bool isAuthenticated() const { return !tokens_.accessToken.empty(); }
-    [[nodiscard]] const AuthTokens& getTokens() const { return tokens_; }
+    void authenticateAsync();
+    [[nodiscard]] AuthState state() const;
+    RefreshResult refreshTokens(const std::string& refreshToken);
+    std::string refreshNow(const std::string& staleToken);
+    [[nodiscard]] bool isAuthenticated() const;
+    [[nodiscard]] AuthTokens getTokens() const;
     void setAuthCallback(const AuthCallback &callback) { authCallback_ = callback; }
+    void setStateCallback(const StateCallback &callback) { stateCallback_ = callback; }
+
+    void startAutoRefresh();
+    void stopAutoRefresh();
 
 private:
     std::string  clientId_;
     std::string clientSecret_;
+    std::string accountsUrl_;
+    mutable std::mutex tokensMutex_;
     AuthTokens tokens_;
     AuthCallback authCallback_;
+    StateCallback stateCallback_;
 
     std::string redirectUri_ = "http://127.0.0.1:8888/callback";
-    std::string scope_ = "user-read-currently-playing user-modify-playback-state";
+    std::string scope_ = "user-read-currently-playing user-read-playback-state user-modify-playback-state";
 
     void startAuthServer() const;
     void stopAuthServer() const;
     [[nodiscard]] std::string buildAuthUrl() const;
     bool exchangeCodeForTokens(const std::string& code);
+    RefreshResult refreshTokensLocked(const std::string& refreshToken);
+    void publishTokens() const;
+    void setState(AuthState state, const std::string& detail = "") const;
+    void refreshLoop();
 
     class Impl;
     std::unique_ptr<Impl> pImpl_;
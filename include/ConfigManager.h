@@ -7,11 +7,18 @@
 
 #pragma once
 
+#include <functional>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include "Types.h"
 
 class ConfigManager {
 public:
+    using SettingsListener = std::function<void(const PerformanceSettings&)>;
+
     static ConfigManager& getInstance();
 
     bool loadConfig();
@@ -21,8 +28,18 @@ public:
 
     [[nodiscard]] std::string getClientId() const { return clientId_; }
     [[nodiscard]] std::string getClientSecret() const { return clientSecret_; }
+    [[nodiscard]] std::string getApiBaseUrl() const { return apiBaseUrl_; }
+    [[nodiscard]] std::string getAccountsBaseUrl() const { return accountsBaseUrl_; }
+    [[nodiscard]] PerformanceSettings getPerformanceSettings() const;
     void setCredentials(const std::string& clientId, const std::string& clientSecret);
 
+    // Listeners run on the watcher thread after every successful reload
+    void addSettingsListener(const SettingsListener& listener);
+    bool startWatching();
+    void stopWatching();
+
+    ~ConfigManager();
+
 private:
     ConfigManager() = default;
 
@@ -31,6 +48,21 @@ private:
 
     std::string clientId_;
     std::string clientSecret_;
+    std::string apiBaseUrl_ = "https://api.spotify.com/v1";
+    std::string accountsBaseUrl_ = "https://accounts.spotify.com";
+
+    mutable std::mutex settingsMutex_;
+    PerformanceSettings settings_;
+    std::vector<SettingsListener> listeners_;
+
+    std::thread watchThread_;
+    int stopFds_[2] = {-1, -1};
+
+    bool readConfig(std::map<std::string, std::string>& values) const;
+    static PerformanceSettings parseSettings(const std::map<std::string, std::string>& values,
+                                             const PerformanceSettings& previous);
+    void reloadSettings();
+    void watchLoop(int inotifyFd);
 };
 
-#endif //SPOTIFYOVERLAY_CONFIGMANAGER_H
\ No newline at end of file
+#endif //SPOTIFYOVERLAY_CONFIGMANAGER_H
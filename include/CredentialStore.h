@@ -0,0 +1,43 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_CREDENTIALSTORE_H
+#define SPOTIFYOVERLAY_CREDENTIALSTORE_H
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+struct Credential {
+    std::string token;
+    std::string authorization;
+    uint64_t generation = 0;
+};
+
+// Holds the current access token as an immutable snapshot. Readers copy it out
+// without taking a lock: they count themselves into the current epoch, and
+// publish frees a replaced snapshot only after that epoch's readers have left.
+// An empty Credential (generation 0) means no token has been published yet.
+class CredentialStore {
+public:
+    CredentialStore() = default;
+    ~CredentialStore();
+    CredentialStore(const CredentialStore&) = delete;
+    CredentialStore& operator=(const CredentialStore&) = delete;
+
+    [[nodiscard]] Credential current() const;
+    Credential publish(const std::string& token);
+
+private:
+    std::atomic<const Credential*> current_{nullptr};
+    std::atomic<uint64_t> epoch_{0};
+    mutable std::atomic<int> readers_[2] = {{0}, {0}};
+    std::mutex writeMutex_;
+    uint64_t generation_ = 0;
+};
+
+#endif //SPOTIFYOVERLAY_CREDENTIALSTORE_H
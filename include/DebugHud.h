@@ -0,0 +1,35 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_DEBUGHUD_H
+#define SPOTIFYOVERLAY_DEBUGHUD_H
+
+#pragma once
+
+#include <QLabel>
+#include <QTimer>
+#include <QWidget>
+
+// Small always-on-top window with the GUI-thread span statistics. Only
+// refreshes while visible, so a hidden HUD costs nothing.
+class DebugHud : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DebugHud(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+
+private:
+    QLabel *label_;
+    QTimer refreshTimer_;
+};
+
+#endif //SPOTIFYOVERLAY_DEBUGHUD_H
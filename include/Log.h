@@ -0,0 +1,37 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_LOG_H
+#define SPOTIFYOVERLAY_LOG_H
+
+#pragma once
+
+#include <atomic>
+#include <iostream>
+#include <ostream>
+#include "Types.h"
+
+// Process-wide verbosity; checked before building hot-path log lines.
+namespace Log {
+    inline std::atomic<LogLevel> level{LogLevel::INFO};
+
+    inline bool enabled(LogLevel wanted) {
+        return wanted <= level.load(std::memory_order_relaxed);
+    }
+
+    inline void setLevel(LogLevel wanted) {
+        level.store(wanted, std::memory_order_relaxed);
+    }
+
+    // Sink for one line at the given level; a null stream when that level is off.
+    inline std::ostream& stream(LogLevel wanted) {
+        if (!enabled(wanted)) {
+            thread_local std::ostream discard(nullptr);
+            return discard;
+        }
+        return wanted <= LogLevel::WARN ? std::cerr : std::cout;
+    }
+}
+
+#endif //SPOTIFYOVERLAY_LOG_H
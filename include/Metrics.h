@@ -0,0 +1,138 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_METRICS_H
+#define SPOTIFYOVERLAY_METRICS_H
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Log-linear histogram of microsecond values: 16 sub-buckets per power of two,
+// so every recorded value is kept to within ~6% of its true size.
+class LatencyHistogram {
+public:
+    void record(uint64_t value);
+
+    [[nodiscard]] uint64_t count() const { return count_; }
+    [[nodiscard]] uint64_t sum() const { return sum_; }
+    [[nodiscard]] uint64_t max() const { return max_; }
+    [[nodiscard]] uint64_t percentile(double fraction) const;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAGNITUDES = 28;
+
+    std::array<uint64_t, MAGNITUDES * SUB_BUCKETS> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+
+    static size_t indexFor(uint64_t value);
+    static uint64_t highestValueAt(size_t index);
+};
+
+struct SpanStats {
+    uint64_t count = 0;
+    double meanMicros = 0;
+    uint64_t p50Micros = 0;
+    uint64_t p99Micros = 0;
+    uint64_t maxMicros = 0;
+    double ratePerSecond = 0;
+};
+
+// The last WINDOW samples of a span, for "how is it doing right now" views
+// that a cumulative histogram smooths away.
+class RollingStats {
+public:
+    void record(uint64_t value, std::chrono::steady_clock::time_point at);
+    [[nodiscard]] SpanStats snapshot(std::chrono::steady_clock::time_point now) const;
+
+private:
+    static constexpr size_t WINDOW = 256;
+
+    std::array<uint64_t, WINDOW> values_{};
+    std::array<std::chrono::steady_clock::time_point, WINDOW> times_{};
+    size_t next_ = 0;
+    size_t size_ = 0;
+};
+
+class Metrics {
+public:
+    static Metrics& getInstance();
+
+    void recordRequest(const std::string& endpoint, std::chrono::microseconds latency, int statusCode);
+    void recordBytes(const std::string& endpoint, uint64_t bytes);
+    void recordRetry(const std::string& endpoint);
+    // Frequent spans pass wakeDumper = false so they ride along with the next
+    // dump instead of keeping an otherwise idle overlay writing every interval
+    void recordSpan(const std::string& name, std::chrono::microseconds duration, bool wakeDumper = true);
+    [[nodiscard]] SpanStats spanStats(const std::string& name) const;
+    [[nodiscard]] SpanStats requestStats(const std::string& endpoint) const;
+
+    bool startDumping(const std::string& path, std::chrono::seconds interval);
+    void stopDumping();
+    [[nodiscard]] std::string renderPrometheus() const;
+
+    ~Metrics();
+
+private:
+    Metrics() = default;
+
+    struct EndpointMetrics {
+        LatencyHistogram latency;
+        std::map<int, uint64_t> statusCodes;
+        uint64_t retries = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Span {
+        LatencyHistogram total;
+        RollingStats recent;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, EndpointMetrics> endpoints_;
+    std::map<std::string, Span> spans_;
+
+    std::thread dumpThread_;
+    std::condition_variable dumpCv_;
+    std::string dumpPath_;
+    std::chrono::seconds dumpInterval_{0};
+    bool dirty_ = false;
+    bool stopping_ = false;
+
+    void markDirty();
+    void dumpLoop();
+    bool writeDump() const;
+};
+
+// Records the lifetime of a scope as a span
+class ScopedSpan {
+public:
+    explicit ScopedSpan(const char* name, bool wakeDumper = true)
+        : name_(name), wakeDumper_(wakeDumper), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedSpan() {
+        Metrics::getInstance().recordSpan(name_, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_), wakeDumper_);
+    }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private:
+    const char* name_;
+    bool wakeDumper_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif //SPOTIFYOVERLAY_METRICS_H
@@ -0,0 +1,55 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_PLAYBACKSTATE_H
+#define SPOTIFYOVERLAY_PLAYBACKSTATE_H
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Types.h"
+
+// Last server snapshot plus the expected effect of commands that the server
+// has not reflected yet. A command is dropped once a snapshot shows its effect,
+// when it fails (which rolls the effect back) or after confirmTimeout. Skips
+// forward borrow their metadata from the known queue.
+class PlaybackState {
+public:
+    explicit PlaybackState(std::chrono::milliseconds confirmTimeout = std::chrono::milliseconds(5000));
+
+    [[nodiscard]] PlayBackAction resolve(PlayBackAction action) const;
+    uint64_t apply(PlayBackAction action);
+    void acknowledge(uint64_t id);
+    void reject(uint64_t id);
+    void reconcile(const SpotifyTrack& snapshot);
+    void setUpcoming(const std::vector<SpotifyTrack>& upcoming);
+
+    [[nodiscard]] SpotifyTrack current() const;
+    [[nodiscard]] bool hasPending() const;
+
+private:
+    struct PendingCommand {
+        uint64_t id;
+        PlayBackAction action;
+        std::string fromTrackId;
+        std::chrono::steady_clock::time_point issuedAt;
+        bool acknowledged;
+    };
+
+    std::chrono::milliseconds confirmTimeout_;
+    SpotifyTrack confirmed_;
+    std::vector<PendingCommand> pending_;
+    std::vector<SpotifyTrack> upcoming_;
+    uint64_t nextId_ = 1;
+    mutable std::mutex mutex_;
+
+    [[nodiscard]] SpotifyTrack effectiveLocked() const;
+    static void advance(SpotifyTrack& track, std::chrono::steady_clock::time_point at);
+    [[nodiscard]] static bool isReflectedBy(const PendingCommand& command, const SpotifyTrack& snapshot);
+};
+
+#endif //SPOTIFYOVERLAY_PLAYBACKSTATE_H
@@ -0,0 +1,40 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_RATELIMITER_H
+#define SPOTIFYOVERLAY_RATELIMITER_H
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include "Types.h"
+
+// Token bucket shared by every endpoint. Polls may not dip into the last
+// commandReserve tokens, prefetches only use the top half of the bucket, and
+// nothing is let through while a Retry-After from the server is still running.
+class RateLimiter {
+public:
+    RateLimiter(double capacity, double refillPerSecond, double commandReserve);
+
+    bool tryAcquire(TaskKind kind);
+    void onRetryAfter(std::chrono::seconds delay);
+    [[nodiscard]] std::chrono::milliseconds blockedFor() const;
+    [[nodiscard]] RateLimitStats getStats() const;
+
+private:
+    double capacity_;
+    double refillPerSecond_;
+    double commandReserve_;
+    double tokens_;
+    std::chrono::steady_clock::time_point lastRefill_;
+    std::chrono::steady_clock::time_point blockedUntil_;
+    RateLimitStats stats_;
+    mutable std::mutex mutex_;
+
+    [[nodiscard]] double tokensAt(std::chrono::steady_clock::time_point now) const;
+    void refill(std::chrono::steady_clock::time_point now);
+};
+
+#endif //SPOTIFYOVERLAY_RATELIMITER_H
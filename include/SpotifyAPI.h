@@ -10,30 +10,55 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <vector>
 #include "Types.h"
+#include "WorkerPool.h"
 
 class SpotifyAPI {
 public:
     using TrackCallback = std::function<void(const SpotifyTrack&)>;
+    using TrackChangeCallback = std::function<void(const SpotifyTrack&, const TrackChanges&)>;
     using ErrorCallback = std::function<void(const std::string&)>;
+    using QueueCallback = std::function<void(const std::vector<SpotifyTrack>&)>;
+    // Receives the token the server rejected and returns a newer one, or "" on failure
+    using TokenRefresher = std::function<std::string(const std::string& rejectedToken)>;
 
-    SpotifyAPI();
+    explicit SpotifyAPI(const std::string &baseUrl = "https://api.spotify.com/v1");
     ~SpotifyAPI();
 
     void setAccessToken(const std::string &token) const;
     void getCurrentTrack(TrackCallback success, ErrorCallback error) const;
     void stopPolling() const;
+    void suspendPolling() const;
+    void resumePolling() const;
 
     void controlPlayback(PlayBackAction action, std::function<void(bool)> callback) const;
-    void startPolling(std::chrono::seconds interval) const;
+    void startPolling(const PollingConfig &config = PollingConfig()) const;
     void getPlaybackState(std::function<void(const SpotifyTrack &)> callback) const;
     void setVolume(int volumePercent, std::function<void(bool)> callback) const;
     void seekToPosition(int positionMs, const std::function<void(bool)> &callback) const;
     bool isPolling() const;
-    void setTrackCallback(const TrackCallback &callback) const;
+    void setTrackCallback(const TrackChangeCallback &callback) const;
     void setErrorCallback(const ErrorCallback &callback) const;
+    void setArtworkSize(int pixels) const;
+    void setQueueCallback(const QueueCallback &callback) const;
+    void setTokenRefresher(const TokenRefresher &refresher) const;
+    void setPollingConfig(const PollingConfig &config) const;
+    void setWorkerLimits(size_t threadCount, size_t queueCapacity) const;
+    void setRequestTimeout(std::chrono::seconds timeout) const;
+    void setPrefetchConfig(const PrefetchConfig &config) const;
+    [[nodiscard]] ConnectionStats getConnectionStats() const;
+    [[nodiscard]] WorkerPoolStats getExecutorStats() const;
+    [[nodiscard]] RateLimitStats getRateLimitStats() const;
+    [[nodiscard]] uint64_t getCoalescedRequestCount() const;
 
 private:
+    void fetchCurrent(TrackCallback success, ErrorCallback error,
+                      std::chrono::steady_clock::time_point notBefore) const;
+    void startFetch() const;
+    void refreshAfterCommand() const;
+    void finishCommand(uint64_t commandId, bool success) const;
+
     class Impl;
     std::unique_ptr<Impl> pImpl_;
 };
@@ -15,57 +15,167 @@
 #include <QApplication>
 #include <QMouseEvent>
 #include <QNetworkAccessManager>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QStaticText>
+#include <QTimer>
 #include <memory>
+#include <vector>
 
 #include "SpotifyAPI.h"
+#include "AlbumArtCache.h"
+#include "AlbumArtPipeline.h"
 
 class SpotifyAPI;
 struct SpotifyTrack;
 
+struct OverlayPaintStats {
+    quint64 paints = 0;
+    quint64 fullPaints = 0;
+    quint64 pixels = 0;
+    quint64 layerRenders = 0;
+    qint64 totalNanos = 0;
+};
+
+struct AlbumArtFetchStats {
+    quint64 started = 0;
+    quint64 completed = 0;
+    quint64 cancelled = 0;
+    quint64 stale = 0;
+    quint64 failed = 0;
+};
+
+// WIDGETS builds the label/button tree; COMPACT paints everything in one
+// widget and hit-tests clicks itself.
+enum class OverlayMode {
+    WIDGETS,
+    COMPACT
+};
+
 class TrackOverlay : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit TrackOverlay(QWidget *parent = nullptr);
+    explicit TrackOverlay(QWidget *parent = nullptr, OverlayMode mode = OverlayMode::WIDGETS);
     ~TrackOverlay() override;
 
-    void updateTrackInfo(const SpotifyTrack& track);
+    void updateTrackInfo(const SpotifyTrack& track, const TrackChanges& changes = TrackChanges::all());
     void setAccessToken(const std::string& token);
-    void startPolling(int intervalSeconds = 5);
+    void startPolling(const PollingConfig& config = PollingConfig());
+    void stopPolling();
+    void setPrefetchConfig(const PrefetchConfig& config);
+    void applySettings(const PerformanceSettings& settings);
+    void setTokenRefresher(const SpotifyAPI::TokenRefresher& refresher);
+    void wake();
+    [[nodiscard]] AlbumArtCacheStats albumArtCacheStats() const { return artCache_.stats(); }
+    [[nodiscard]] OverlayPaintStats paintStats() const { return paintStats_; }
+    [[nodiscard]] AlbumArtFetchStats albumArtFetchStats() const { return artFetchStats_; }
 
 protected:
 
-    void paintEvent(QPaintEvent *event);
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void enterEvent(QEnterEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private slots:
     void onImageDownloaded(QNetworkReply* reply);
+    void onAlbumArtRendered(const QString& url, const QImage& image);
+    void onAlbumArtMissed(const QString& url, bool prefetch);
     void setDefaultStyles() const;
 
 private:
-    QLabel *albumArtLabel;
-    QLabel *trackLabel;
-    QLabel *artistLabel;
+    OverlayMode mode_;
+
+    // Only created by buildWidgets(); compact mode paints everything itself and leaves them null
+    QLabel *albumArtLabel{};
+    QLabel *trackLabel{};
+    QLabel *artistLabel{};
 
     QHBoxLayout *mainLayout{};
-    QVBoxLayout *textLayout;
-    QGridLayout *btnLayout;
+    QVBoxLayout *textLayout{};
+    QGridLayout *btnLayout{};
 
-    QPushButton *playPause;
-    QPushButton *nextTrack;
-    QPushButton *backTrack;
+    QPushButton *playPause{};
+    QPushButton *nextTrack{};
+    QPushButton *backTrack{};
 
     std::unique_ptr<SpotifyAPI> spotify_api_;
     QNetworkAccessManager *networkManager;
-
-    bool isPlaying{};
+    AlbumArtCache artCache_;
+    AlbumArtPipeline *artPipeline_{};
+
+    QString currentArtUrl_;
+    quint64 artGeneration_ = 0;
+    QNetworkReply *artReply_{};
+    QHash<QString, QNetworkReply*> pendingArt_;
+    QSet<QString> diskLookups_;
+    AlbumArtFetchStats artFetchStats_;
+    PrefetchConfig prefetchConfig_;
+    PerformanceSettings settings_;
+    SpotifyAPI::TokenRefresher tokenRefresher_;
+    QElapsedTimer prefetchWindow_;
+    qint64 prefetchBytes_ = 0;
+
+    QPixmap background_;
+    QPixmap defaultArt_;
+    OverlayPaintStats paintStats_;
+
+    QPixmap compactArt_;
+    QStaticText compactTrack_;
+    QStaticText compactArtist_;
+    QFont trackFont_;
+    QFont artistFont_;
+    QFont buttonFont_;
+    int pressedButton_ = -1;
+
+    // Progress is interpolated locally from the last snapshot's anchor
+    struct ProgressState {
+        int anchorMs = 0;
+        std::chrono::steady_clock::time_point anchorAt;
+        int durationMs = 0;
+        bool playing = false;
+        int pixels = -1;
+    } progress_;
+    QTimer *progressTimer_{};
+
+    // What the widgets currently show, so updates only touch what changed.
+    struct DisplayState {
+        QString trackText;
+        QString artistText;
+        bool isPlaying = false;
+        bool hasPlayState = false;
+        bool controlsVisible = false;
+    } display_;
 
     bool isDragging = false;
     QPoint dragStartPosition;
     QPoint dragPosition;
 
     void loadAlbumArt(const std::string& imageUrl);
+    void downloadAlbumArt(const QString& url, bool prefetch);
+    void prefetchAlbumArt(const std::vector<SpotifyTrack>& tracks);
     QPixmap getDefaultAlbumArt();
+    void renderBackground();
+
+    void buildWidgets();
+    void showArt(const QPixmap& pixmap);
+    void showText(const QString& trackText, const QString& artistText);
+    void showPlayState(bool playing);
+    void showControls();
+    void paintCompact(QPainter& painter) const;
+    [[nodiscard]] int compactButtonAt(const QPoint& pos) const;
+    void triggerAction(PlayBackAction action) const;
+
+    void resyncProgress(const SpotifyTrack& track);
+    void scheduleProgressTimer();
+    void advanceProgress();
+    void paintProgress(QPainter& painter) const;
+    [[nodiscard]] int progressPixels() const;
 };
 
 #endif //SPOTIFYOVERLAY_TRACKOVERLAY_H
\ No newline at end of file
@@ -0,0 +1,102 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_TRACKPARSER_H
+#define SPOTIFYOVERLAY_TRACKPARSER_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Types.h"
+
+struct AlbumImage {
+    std::string url;
+    int width = 0;
+    int height = 0;
+};
+
+// Streaming reader for Spotify player responses. Only the fields the overlay
+// shows are copied out; everything else (markets, external ids, ...) is
+// skipped while lexing. Buffers are kept between calls, so one instance
+// must not be used by two threads at once.
+class TrackParser {
+public:
+    TrackParser();
+
+    bool parseCurrentlyPlaying(const std::string& body, SpotifyTrack& track, int minImageSize);
+    bool parseQueue(const std::string& body, std::vector<SpotifyTrack>& tracks, size_t limit, int minImageSize);
+
+    // nlohmann::json SAX interface
+    bool null();
+    bool boolean(bool value);
+    bool number_integer(int64_t value);
+    bool number_unsigned(uint64_t value);
+    bool number_float(double value, const std::string& raw);
+    bool string(std::string& value);
+    bool binary(std::vector<uint8_t>& value);
+    bool start_object(std::size_t elements);
+    bool end_object();
+    bool start_array(std::size_t elements);
+    bool end_array();
+    bool key(std::string& value);
+
+    template<typename Exception>
+    bool parse_error(std::size_t, const std::string&, const Exception&) { return false; }
+
+private:
+    enum class Mode {
+        CURRENTLY_PLAYING,
+        QUEUE
+    };
+
+    enum class Field {
+        OTHER,
+        ROOT,
+        ELEMENT,
+        IS_PLAYING,
+        PROGRESS_MS,
+        TIMESTAMP,
+        ITEM,
+        QUEUE,
+        ID,
+        NAME,
+        DURATION_MS,
+        ARTISTS,
+        ALBUM,
+        IMAGES,
+        URL,
+        WIDTH,
+        HEIGHT
+    };
+
+    struct Frame {
+        Field field;
+        bool array;
+    };
+
+    Mode mode_ = Mode::CURRENTLY_PLAYING;
+    int minImageSize_ = 0;
+    SpotifyTrack* track_ = nullptr;
+    std::vector<SpotifyTrack>* queue_ = nullptr;
+    size_t queueLimit_ = 0;
+
+    std::vector<Frame> path_;
+    Field key_ = Field::OTHER;
+    std::vector<AlbumImage> images_;
+    AlbumImage image_;
+
+    void reset(Mode mode, int minImageSize);
+    [[nodiscard]] const AlbumImage* selectImage() const;
+    bool push(bool array);
+    bool integer(int64_t value);
+
+    [[nodiscard]] size_t trackDepth() const;
+    [[nodiscard]] bool inRoot() const;
+    [[nodiscard]] bool inItem() const;
+    [[nodiscard]] bool inArtist() const;
+    [[nodiscard]] bool inImage() const;
+};
+
+#endif //SPOTIFYOVERLAY_TRACKPARSER_H
@@ -9,40 +9,140 @@
 
 #include <string>
 #include <chrono>
+#include <cstdint>
 #include <utility>
 
 struct SpotifyTrack {
+    std::string id;
     std::string name;
     std::string artist;
     std::string imageUrl;
     bool isPlaying;
+    int progressMs = 0;
+    int durationMs = 0;
+    int64_t timestamp = 0;
+    std::chrono::steady_clock::time_point fetchedAt;
 
     explicit SpotifyTrack (std::string  name = "", std::string  artist = "",
         std::string  imageUrl = "", const bool isPlaying = false)
             : name(std::move(name)), artist(std::move(artist)), imageUrl(std::move(imageUrl)), isPlaying(isPlaying) {}
 };
 
+struct TrackChanges {
+    bool track = false;
+    bool playState = false;
+    bool artwork = false;
+    bool progress = false;
+
+    [[nodiscard]] bool any() const { return track || playState || artwork || progress; }
+
+    static TrackChanges all() { return TrackChanges{true, true, true, true}; }
+};
+
 struct AuthTokens {
     std::string accessToken;
     std::string refreshToken;
     std::chrono::system_clock::time_point lastUpdate;
+    std::chrono::system_clock::time_point expiresAt;
 
     AuthTokens()
         : accessToken(""),
           refreshToken(""),
-          lastUpdate(std::chrono::system_clock::time_point{}) {}
+          lastUpdate(std::chrono::system_clock::time_point{}),
+          expiresAt(std::chrono::system_clock::time_point{}) {}
 
     AuthTokens(const std::string& access, const std::string& refresh, const std::chrono::system_clock::time_point& update)
         : accessToken(access),
           refreshToken(refresh),
-          lastUpdate(update) {}
+          lastUpdate(update),
+          expiresAt(std::chrono::system_clock::time_point{}) {}
+
+    // Tokens saved before expires_in was stored are assumed to last the usual hour
+    [[nodiscard]] std::chrono::system_clock::time_point expiry() const {
+        return expiresAt != std::chrono::system_clock::time_point{} ? expiresAt : lastUpdate + std::chrono::hours(1);
+    }
 
     [[nodiscard]] bool isValid() const {
-        return !accessToken.empty() &&
-            std::chrono::system_clock::now() - lastUpdate < std::chrono::hours(24);
+        return !accessToken.empty() && std::chrono::system_clock::now() < expiry();
+    }
+};
+
+struct PollingConfig {
+    std::chrono::milliseconds minInterval{1000};
+    std::chrono::milliseconds maxInterval{10000};
+    std::chrono::milliseconds pausedInterval{30000};
+    std::chrono::milliseconds idleInterval{60000};
+    std::chrono::milliseconds boundaryDelay{500};
+    std::chrono::milliseconds deepIdleAfter{10 * 60 * 1000};
+};
+
+struct PrefetchConfig {
+    int lookahead = 3;
+    std::chrono::seconds minQueueInterval{30};
+    int maxRequestsPerHour = 60;
+    int64_t maxBytesPerHour = 8 * 1024 * 1024;
+};
+
+enum class LogLevel {
+    ERROR,
+    WARN,
+    INFO,
+    DEBUG
+};
+
+struct PerformanceSettings {
+    PollingConfig polling;
+    PrefetchConfig prefetch;
+    size_t workerThreads = 2;
+    size_t workerQueue = 8;
+    int artMemoryEntries = 32;
+    int64_t artDiskBytes = 32 * 1024 * 1024;
+    std::chrono::seconds requestTimeout{10};
+    LogLevel logLevel = LogLevel::INFO;
+};
+
+struct RateLimitStats {
+    double tokens = 0;
+    double capacity = 0;
+    uint64_t granted = 0;
+    uint64_t denied = 0;
+    uint64_t throttled = 0;
+    std::chrono::milliseconds retryAfter{0};
+
+    [[nodiscard]] double usage() const {
+        return capacity > 0 ? 1.0 - tokens / capacity : 0.0;
+    }
+};
+
+struct ConnectionStats {
+    uint64_t requests = 0;
+    uint64_t handshakes = 0;
+
+    [[nodiscard]] uint64_t reused() const {
+        return requests > handshakes ? requests - handshakes : 0;
     }
 };
 
+enum class TaskKind {
+    POLL,
+    COMMAND,
+    PREFETCH
+};
+
+enum class AuthState {
+    IDLE,
+    AWAITING_BROWSER,
+    EXCHANGING,
+    AUTHENTICATED,
+    FAILED
+};
+
+enum class RefreshResult {
+    REFRESHED,
+    REJECTED,
+    FAILED
+};
+
 enum class PlayBackAction {
     PLAY,
     PAUSE,
@@ -0,0 +1,74 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#ifndef SPOTIFYOVERLAY_WORKERPOOL_H
+#define SPOTIFYOVERLAY_WORKERPOOL_H
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Types.h"
+
+enum class SubmitResult {
+    QUEUED,
+    DUPLICATE,
+    FULL
+};
+
+struct WorkerPoolStats {
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t dropped = 0;
+    uint64_t rejected = 0;
+    size_t queued = 0;
+    size_t peakQueued = 0;
+};
+
+// Fixed set of threads fed from a bounded queue. Commands run before polls and
+// polls before prefetches; when the queue is full the least important waiting
+// task is dropped to make room, and a background task that already has a twin
+// waiting in the queue is not queued again. Both limits can be changed live.
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    WorkerPool(size_t threadCount, size_t capacity);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    SubmitResult submit(Task task, TaskKind kind);
+    void resize(size_t threadCount, size_t capacity);
+    void shutdown();
+    [[nodiscard]] WorkerPoolStats getStats() const;
+
+private:
+    struct Entry {
+        Task task;
+        TaskKind kind;
+    };
+
+    size_t capacity_;
+    std::deque<Entry> queue_;
+    std::vector<std::thread> threads_;
+    std::vector<std::thread::id> retired_;
+    size_t targetThreads_ = 0;
+    size_t liveThreads_ = 0;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    WorkerPoolStats stats_;
+
+    void workerLoop();
+    bool takeNext(Entry& out);
+};
+
+#endif //SPOTIFYOVERLAY_WORKERPOOL_H
@@ -0,0 +1,122 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/AlbumArtCache.h"
+#include "../include/Log.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <iostream>
+
+AlbumArtCache::AlbumArtCache(int memoryEntries, qint64 diskBytes)
+    : memory_(memoryEntries),
+      directory_(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/albumart"),
+      diskLimit_(diskBytes)
+{
+    if (!QDir().mkpath(directory_)) {
+        Log::stream(LogLevel::ERROR) << "Failed to create album art cache at " << directory_.toStdString() << std::endl;
+    }
+}
+
+bool AlbumArtCache::findPixmap(const QString& url, qreal devicePixelRatio, QPixmap& pixmap) {
+    if (const QPixmap* cached = memory_.object(memoryKey(url, devicePixelRatio))) {
+        pixmap = *cached;
+        ++stats_.memoryHits;
+        return true;
+    }
+
+    ++stats_.memoryMisses;
+    return false;
+}
+
+bool AlbumArtCache::containsPixmap(const QString& url, qreal devicePixelRatio) const {
+    return memory_.contains(memoryKey(url, devicePixelRatio));
+}
+
+void AlbumArtCache::insertPixmap(const QString& url, const QPixmap& pixmap) {
+    memory_.insert(memoryKey(url, pixmap.devicePixelRatio()), new QPixmap(pixmap));
+}
+
+bool AlbumArtCache::readBytes(const QString& url, QByteArray& data) {
+    QFile file(pathFor(url));
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMutexLocker lock(&diskStatsMutex_);
+        ++diskStats_.diskMisses;
+        return false;
+    }
+
+    data = file.readAll();
+
+    // Keep the modification time as "last used" so trimming drops the coldest covers
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    QMutexLocker lock(&diskStatsMutex_);
+    ++diskStats_.diskHits;
+    return true;
+}
+
+void AlbumArtCache::writeBytes(const QString& url, const QByteArray& data) {
+    const QString path = pathFor(url);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        Log::stream(LogLevel::ERROR) << "Failed to write album art cache file: " << path.toStdString() << std::endl;
+        return;
+    }
+
+    trimDisk();
+}
+
+void AlbumArtCache::setLimits(int memoryEntries, qint64 diskBytes) {
+    memory_.setMaxCost(memoryEntries);
+    diskLimit_.storeRelaxed(diskBytes);
+}
+
+AlbumArtCacheStats AlbumArtCache::stats() const {
+    AlbumArtCacheStats stats = stats_;
+    {
+        QMutexLocker lock(&diskStatsMutex_);
+        stats.diskHits = diskStats_.diskHits;
+        stats.diskMisses = diskStats_.diskMisses;
+        stats.diskBytes = diskStats_.diskBytes;
+    }
+    stats.memoryEntries = static_cast<int>(memory_.count());
+    return stats;
+}
+
+// The same cover is rendered at a different size on each screen scale
+QString AlbumArtCache::memoryKey(const QString& url, qreal devicePixelRatio) {
+    return url + QLatin1Char('@') + QString::number(devicePixelRatio);
+}
+
+QString AlbumArtCache::pathFor(const QString& url) const {
+    const QByteArray digest = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return directory_ + "/" + QString::fromLatin1(digest);
+}
+
+void AlbumArtCache::trimDisk() {
+    // Sized from the directory itself, since other overlay instances share it
+    const auto files = QDir(directory_).entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+
+    qint64 diskBytes = 0;
+    for (const QFileInfo& info : files) {
+        diskBytes += info.size();
+    }
+
+    const qint64 limit = diskLimit_.loadRelaxed();
+    for (const QFileInfo& info : files) {
+        if (diskBytes <= limit) break;
+
+        if (QFile::remove(info.absoluteFilePath())) {
+            diskBytes -= info.size();
+        }
+    }
+
+    QMutexLocker lock(&diskStatsMutex_);
+    diskStats_.diskBytes = diskBytes;
+}
@@ -0,0 +1,87 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/AlbumArtPipeline.h"
+#include "../include/AlbumArtCache.h"
+#include <QBuffer>
+#include <QImageReader>
+#include <QPainter>
+#include <QPainterPath>
+#include <QtMath>
+
+AlbumArtPipeline::AlbumArtPipeline(AlbumArtCache *cache, QObject *parent) : QObject(parent), cache_(cache) {
+    pool_.setMaxThreadCount(1);
+    trimDisk();
+}
+
+AlbumArtPipeline::~AlbumArtPipeline() {
+    pool_.clear();
+    pool_.waitForDone();
+}
+
+void AlbumArtPipeline::load(const QString& url, int size, qreal devicePixelRatio, bool prefetch) {
+    pool_.start([this, url, size, devicePixelRatio, prefetch]() {
+        QByteArray imageData;
+        if (cache_->readBytes(url, imageData)) {
+            emit finished(url, render(imageData, size, devicePixelRatio));
+        } else {
+            emit diskMissed(url, prefetch);
+        }
+    });
+}
+
+void AlbumArtPipeline::store(const QString& url, const QByteArray& imageData, int size, qreal devicePixelRatio,
+                             bool decode) {
+    pool_.start([this, url, imageData, size, devicePixelRatio, decode]() {
+        cache_->writeBytes(url, imageData);
+        if (decode) {
+            emit finished(url, render(imageData, size, devicePixelRatio));
+        }
+    });
+}
+
+void AlbumArtPipeline::trimDisk() {
+    pool_.start([this]() {
+        cache_->trimDisk();
+    });
+}
+
+QImage AlbumArtPipeline::render(const QByteArray& imageData, int size, qreal devicePixelRatio) {
+    const int pixels = qCeil(size * devicePixelRatio);
+
+    QBuffer buffer;
+    buffer.setData(imageData);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer);
+    const QSize original = reader.size();
+
+    // Lets the JPEG decoder skip work by decoding straight to a smaller size
+    if (original.isValid() && original.width() > pixels && original.height() > pixels) {
+        reader.setScaledSize(original.scaled(pixels, pixels, Qt::KeepAspectRatioByExpanding));
+    }
+
+    QImage decoded = reader.read();
+    if (decoded.isNull()) return {};
+
+    if (decoded.width() < pixels || decoded.height() < pixels ||
+        (decoded.width() > pixels && decoded.height() > pixels)) {
+        decoded = decoded.scaled(pixels, pixels, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+    }
+
+    QImage rounded(pixels, pixels, QImage::Format_ARGB32_Premultiplied);
+    rounded.fill(Qt::transparent);
+
+    QPainter painter(&rounded);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QPainterPath path;
+    path.addRoundedRect(0, 0, pixels, pixels, 8 * devicePixelRatio, 8 * devicePixelRatio);
+    painter.setClipPath(path);
+    painter.drawImage((pixels - decoded.width()) / 2, (pixels - decoded.height()) / 2, decoded);
+    painter.end();
+
+    rounded.setDevicePixelRatio(devicePixelRatio);
+    return rounded;
+}
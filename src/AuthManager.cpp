@@ -3,8 +3,14 @@
 //
 
 #include "../include/AuthManager.h"
+#include "../include/Log.h"
+#include "../include/Metrics.h"
+#include "../include/ConfigManager.h"
 
 #include <future>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
 #include <cpprest/http_client.h>
 #include <cpprest/http_listener.h>
 #include <cpprest/json.h>
@@ -16,32 +22,59 @@ using namespace web::http;
 using namespace web::http::client;
 using namespace web::http::experimental::listener;
 
+namespace {
+    http_response sendTokenRequest(http_client& client, const http_request& request) {
+        const auto started = std::chrono::steady_clock::now();
+        const auto elapsed = [&started]() {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        };
+
+        try {
+            auto response = client.request(request).get();
+            Metrics::getInstance().recordRequest("/api/token", elapsed(), response.status_code());
+            return response;
+        } catch (const std::exception&) {
+            Metrics::getInstance().recordRequest("/api/token", elapsed(), 0);
+            throw;
+        }
+    }
+}
+
 class AuthManager::Impl {
 public:
-    http_listener listener;
+    // Only bound while an interactive login is waiting for the browser
+    std::unique_ptr<http_listener> listener;
     std::string authCode;
     std::promise<std::string> codePromise;
     bool codeReceived = false;
 
-    Impl() : listener(uri_builder("http://127.0.0.1").set_port(8888).to_uri()) {
-        std::cout << "AuthManager::Impl constructor started" << std::endl;
+    std::mutex refreshMutex;
+    std::thread refreshThread;
+    std::mutex scheduleMutex;
+    std::condition_variable scheduleCv;
+    bool autoRefresh = false;
+
+    std::thread authThread;
+    std::atomic<AuthState> state{AuthState::IDLE};
+    std::atomic<bool> cancelled{false};
+
+    void createListener() {
+        listener = std::make_unique<http_listener>(uri_builder("http://127.0.0.1").set_port(8888).to_uri());
 
-        listener.support(methods::GET, [this](http_request request) {
+        listener->support(methods::GET, [this](http_request request) {
             handleCallback(std::move(request));
         });
-
-        std::cout << "AuthManager::Impl constructor completed" << std::endl;
     }
 
     void handleCallback(const http_request &request) {
-        std::cout << "Received callback request" << std::endl;
+        Log::stream(LogLevel::INFO) << "Received callback request" << std::endl;
 
         auto query = uri::split_query(request.request_uri().query());
         const auto it = query.find("code");
 
         if (it != query.end() && !codeReceived) {
             authCode = it->second;
-            std::cout << "Got authorization code: " << authCode.substr(0, 10) << "..." << std::endl;
+            Log::stream(LogLevel::INFO) << "Got authorization code: " << authCode.substr(0, 10) << "..." << std::endl;
 
             codePromise.set_value(authCode);
             codeReceived = true;
@@ -55,9 +88,9 @@ public:
 
             request.reply(response).wait();
 
-            std::cout << "Sent success response to browser" << std::endl;
+            Log::stream(LogLevel::INFO) << "Sent success response to browser" << std::endl;
         } else {
-            std::cerr << "Missing authorization code or already received" << std::endl;
+            Log::stream(LogLevel::ERROR) << "Missing authorization code or already received" << std::endl;
         }
     }
 
@@ -68,34 +101,133 @@ public:
     }
 };
 
-AuthManager::AuthManager(const std::string& clientId, const std::string& clientSecret)
+AuthManager::AuthManager(const std::string& clientId, const std::string& clientSecret,
+                         const std::string& accountsUrl)
     : clientId_(clientId),
       clientSecret_(clientSecret),
+      accountsUrl_(accountsUrl),
       authCallback_(nullptr)
 {
-    std::cout << "AuthManager constructor started" << std::endl;
+    Log::stream(LogLevel::INFO) << "AuthManager constructor started" << std::endl;
     try {
         pImpl_ = std::make_unique<Impl>();
-        std::cout << "AuthManager constructor completed successfully" << std::endl;
+        Log::stream(LogLevel::INFO) << "AuthManager constructor completed successfully" << std::endl;
     } catch (const std::exception& e) {
-        std::cerr << "AuthManager constructor failed: " << e.what() << std::endl;
+        Log::stream(LogLevel::ERROR) << "AuthManager constructor failed: " << e.what() << std::endl;
         throw;
     }
 }
 AuthManager::~AuthManager() {
+    pImpl_->cancelled = true;
+    if (pImpl_->authThread.joinable()) {
+        pImpl_->authThread.join();
+    }
+
+    stopAutoRefresh();
     stopAuthServer();
 }
 
+bool AuthManager::isAuthenticated() const {
+    std::lock_guard<std::mutex> lock(tokensMutex_);
+    return !tokens_.accessToken.empty();
+}
+
+AuthTokens AuthManager::getTokens() const {
+    std::lock_guard<std::mutex> lock(tokensMutex_);
+    return tokens_;
+}
+
+bool AuthManager::restoreSession() {
+    AuthTokens stored;
+    const bool fresh = ConfigManager::getInstance().loadTokens(stored);
+
+    if (stored.refreshToken.empty()) {
+        Log::stream(LogLevel::INFO) << "No saved session" << std::endl;
+        return false;
+    }
+
+    if (fresh) {
+        Log::stream(LogLevel::INFO) << "Restored saved session" << std::endl;
+        std::lock_guard<std::mutex> lock(tokensMutex_);
+        tokens_ = stored;
+        return true;
+    }
+
+    Log::stream(LogLevel::INFO) << "Saved session is stale, refreshing..." << std::endl;
+    setState(AuthState::EXCHANGING, "Refreshing saved session");
+
+    // Only a rejected refresh token needs a new login; a flaky network at boot just waits
+    constexpr auto maxBackoff = std::chrono::minutes(5);
+    std::chrono::seconds backoff(2);
+
+    while (true) {
+        switch (refreshTokens(stored.refreshToken)) {
+            case RefreshResult::REFRESHED:
+                return true;
+            case RefreshResult::REJECTED:
+                Log::stream(LogLevel::WARN) << "Saved session was revoked, signing in again" << std::endl;
+                return false;
+            case RefreshResult::FAILED:
+                break;
+        }
+
+        Log::stream(LogLevel::WARN) << "Could not refresh saved session, retrying in " << backoff.count() << "s" << std::endl;
+        setState(AuthState::EXCHANGING, "Offline, retrying in " + std::to_string(backoff.count()) + "s");
+
+        const auto retryAt = std::chrono::steady_clock::now() + backoff;
+        while (std::chrono::steady_clock::now() < retryAt) {
+            if (pImpl_->cancelled) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        backoff = std::min<std::chrono::seconds>(backoff * 2, maxBackoff);
+    }
+}
+
+void AuthManager::authenticateAsync() {
+    const AuthState current = state();
+    if (current == AuthState::AWAITING_BROWSER || current == AuthState::EXCHANGING) {
+        Log::stream(LogLevel::INFO) << "Authentication already in progress" << std::endl;
+        return;
+    }
+
+    if (pImpl_->authThread.joinable()) {
+        pImpl_->authThread.join();
+    }
+
+    pImpl_->cancelled = false;
+    pImpl_->authThread = std::thread([this]() {
+        if (restoreSession()) {
+            setState(AuthState::AUTHENTICATED, "Restored saved session");
+            return;
+        }
+        if (!pImpl_->cancelled) {
+            authenticate();
+        }
+    });
+}
+
+AuthState AuthManager::state() const {
+    return pImpl_->state;
+}
+
+void AuthManager::setState(AuthState state, const std::string& detail) const {
+    pImpl_->state = state;
+
+    if (stateCallback_) {
+        stateCallback_(state, detail);
+    }
+}
+
 bool AuthManager::authenticate() {
     try {
-        std::cout << "Starting authentication process..." << std::endl;
+        Log::stream(LogLevel::INFO) << "Starting authentication process..." << std::endl;
 
         pImpl_->resetPromise();
 
         startAuthServer();
 
         const std::string authUrl = buildAuthUrl();
-        std::cout << "Opening browser with auth URL" << std::endl;
+        Log::stream(LogLevel::INFO) << "Opening browser with auth URL" << std::endl;
 
         std::string command;
 
@@ -103,38 +235,56 @@ bool AuthManager::authenticate() {
 
         int result = system(command.c_str());
         if (result != 0) {
-            std::cout << "Could not open browser automatically. Please visit this URL manually:" << std::endl;
-            std::cout << authUrl << std::endl;
+            Log::stream(LogLevel::INFO) << "Could not open browser automatically. Please visit this URL manually:" << std::endl;
+            Log::stream(LogLevel::INFO) << authUrl << std::endl;
         }
 
-        std::cout << "Waiting for authorization code (timeout: 60 seconds)..." << std::endl;
-        auto codeFuture = pImpl_->codePromise.get_future();
-        const auto status = codeFuture.wait_for(std::chrono::seconds(60));
+        Log::stream(LogLevel::INFO) << "Waiting for authorization code (timeout: 60 seconds)..." << std::endl;
+        setState(AuthState::AWAITING_BROWSER, authUrl);
 
-        if (status == std::future_status::timeout) {
-            std::cerr << "Authentication timeout - no response within 60 seconds" << std::endl;
-            stopAuthServer();
-            return false;
+        // Wait in short slices so shutting down does not hang on an abandoned login
+        auto codeFuture = pImpl_->codePromise.get_future();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+        while (codeFuture.wait_for(std::chrono::milliseconds(200)) == std::future_status::timeout) {
+            if (pImpl_->cancelled || std::chrono::steady_clock::now() >= deadline) {
+                Log::stream(LogLevel::ERROR) << "Authentication timeout - no response within 60 seconds" << std::endl;
+                stopAuthServer();
+                setState(AuthState::FAILED, "No response from the browser");
+                return false;
+            }
         }
 
         const std::string code = codeFuture.get();
-        std::cout << "Successfully received authorization code" << std::endl;
+        Log::stream(LogLevel::INFO) << "Successfully received authorization code" << std::endl;
         stopAuthServer();
 
-        return exchangeCodeForTokens(code);
+        setState(AuthState::EXCHANGING, "Exchanging authorization code");
+        if (!exchangeCodeForTokens(code)) {
+            setState(AuthState::FAILED, "Token exchange failed");
+            return false;
+        }
+
+        setState(AuthState::AUTHENTICATED);
+        return true;
 
     } catch (const std::exception& e) {
-        std::cerr << "Authentication error: " << e.what() << std::endl;
+        Log::stream(LogLevel::ERROR) << "Authentication error: " << e.what() << std::endl;
         stopAuthServer();
+        setState(AuthState::FAILED, e.what());
         return false;
     }
 }
 
-bool AuthManager::refreshTokens(const std::string& refreshToken) {
+RefreshResult AuthManager::refreshTokens(const std::string& refreshToken) {
+    std::lock_guard<std::mutex> refreshLock(pImpl_->refreshMutex);
+    return refreshTokensLocked(refreshToken);
+}
+
+RefreshResult AuthManager::refreshTokensLocked(const std::string& refreshToken) {
     try {
-        std::cout << "Refreshing tokens..." << std::endl;
+        Log::stream(LogLevel::INFO) << "Refreshing tokens..." << std::endl;
 
-        http_client client(U("https://accounts.spotify.com"));
+        http_client client(accountsUrl_);
         http_request request(methods::POST);
 
         request.set_request_uri(U("/api/token"));
@@ -145,79 +295,175 @@ bool AuthManager::refreshTokens(const std::string& refreshToken) {
 
         request.set_body(body, "application/x-www-form-urlencoded");
 
-        std::cout << "Sending refresh token request..." << std::endl;
-        const auto response = client.request(request).get();
+        Log::stream(LogLevel::INFO) << "Sending refresh token request..." << std::endl;
+        const auto response = sendTokenRequest(client, request);
 
-        std::cout << "Refresh response status: " << response.status_code() << std::endl;
+        Log::stream(LogLevel::INFO) << "Refresh response status: " << response.status_code() << std::endl;
 
         if (response.status_code() != status_codes::OK) {
-            std::cerr << "Token refresh failed with status: " << response.status_code() << std::endl;
-            return false;
+            Log::stream(LogLevel::ERROR) << "Token refresh failed with status: " << response.status_code() << std::endl;
+
+            // invalid_grant: the refresh token was revoked or has expired
+            const bool rejected = response.status_code() == status_codes::BadRequest ||
+                                  response.status_code() == status_codes::Unauthorized;
+            return rejected ? RefreshResult::REJECTED : RefreshResult::FAILED;
         }
 
         auto json = response.extract_json().get();
-        tokens_.accessToken = json[U("access_token")].as_string();
-
-        if (json.has_field(U("refresh_token"))) {
-            tokens_.refreshToken = json[U("refresh_token")].as_string();
-        } else {
-            tokens_.refreshToken = refreshToken;
+        {
+            std::lock_guard<std::mutex> lock(tokensMutex_);
+            tokens_.accessToken = json[U("access_token")].as_string();
+
+            if (json.has_field(U("refresh_token"))) {
+                tokens_.refreshToken = json[U("refresh_token")].as_string();
+            } else {
+                tokens_.refreshToken = refreshToken;
+            }
+
+            tokens_.lastUpdate = std::chrono::system_clock::now();
+            tokens_.expiresAt = tokens_.lastUpdate + std::chrono::seconds(
+                json.has_field(U("expires_in")) ? json[U("expires_in")].as_integer() : 3600);
         }
 
-        tokens_.lastUpdate = std::chrono::system_clock::now();
-
-        std::cout << "Tokens refreshed successfully" << std::endl;
+        Log::stream(LogLevel::INFO) << "Tokens refreshed successfully" << std::endl;
 
-        if (authCallback_) {
-            authCallback_(tokens_);
-        }
+        publishTokens();
 
-        return true;
+        return RefreshResult::REFRESHED;
     } catch (const std::exception& e) {
-        std::cerr << "Token refresh error: " << e.what() << std::endl;
-        return false;
+        Log::stream(LogLevel::ERROR) << "Token refresh error: " << e.what() << std::endl;
+        return RefreshResult::FAILED;
     }
 }
 
 void AuthManager::startAuthServer() const {
     try {
-        std::cout << "Starting auth server..." << std::endl;
-        pImpl_->listener.open().wait();
-        std::cout << "Auth server started successfully on http://127.0.0.1:8888" << std::endl;
+        Log::stream(LogLevel::INFO) << "Starting auth server..." << std::endl;
+        if (!pImpl_->listener) {
+            pImpl_->createListener();
+        }
+        pImpl_->listener->open().wait();
+        Log::stream(LogLevel::INFO) << "Auth server started successfully on http://127.0.0.1:8888" << std::endl;
     } catch (const std::exception& e) {
-        std::cerr << "Failed to start auth server: " << e.what() << std::endl;
+        Log::stream(LogLevel::ERROR) << "Failed to start auth server: " << e.what() << std::endl;
         throw;
     }
 }
 
 void AuthManager::stopAuthServer() const {
     try {
-        if (pImpl_) {
-            pImpl_->listener.close().wait();
-            std::cout << "Auth server stopped" << std::endl;
+        if (pImpl_ && pImpl_->listener) {
+            pImpl_->listener->close().wait();
+            pImpl_->listener.reset();
+            Log::stream(LogLevel::INFO) << "Auth server stopped" << std::endl;
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error stopping auth server: " << e.what() << std::endl;
+        Log::stream(LogLevel::ERROR) << "Error stopping auth server: " << e.what() << std::endl;
+    }
+}
+
+void AuthManager::publishTokens() const {
+    const AuthTokens tokens = getTokens();
+
+    if (!ConfigManager::getInstance().saveTokens(tokens)) {
+        Log::stream(LogLevel::ERROR) << "Failed to save tokens" << std::endl;
+    }
+
+    if (authCallback_) {
+        authCallback_(tokens);
+    }
+}
+
+std::string AuthManager::refreshNow(const std::string& staleToken) {
+    std::lock_guard<std::mutex> refreshLock(pImpl_->refreshMutex);
+
+    // Another caller may have refreshed while this one waited; reuse its token
+    const AuthTokens tokens = getTokens();
+    if (!tokens.accessToken.empty() && tokens.accessToken != staleToken) {
+        return tokens.accessToken;
+    }
+
+    if (tokens.refreshToken.empty() || refreshTokensLocked(tokens.refreshToken) != RefreshResult::REFRESHED) {
+        return {};
+    }
+    return getTokens().accessToken;
+}
+
+void AuthManager::startAutoRefresh() {
+    std::lock_guard<std::mutex> lock(pImpl_->scheduleMutex);
+    if (pImpl_->autoRefresh) return;
+
+    pImpl_->autoRefresh = true;
+    pImpl_->refreshThread = std::thread([this]() { refreshLoop(); });
+}
+
+void AuthManager::stopAutoRefresh() {
+    {
+        std::lock_guard<std::mutex> lock(pImpl_->scheduleMutex);
+        pImpl_->autoRefresh = false;
+    }
+    pImpl_->scheduleCv.notify_all();
+
+    if (pImpl_->refreshThread.joinable()) {
+        pImpl_->refreshThread.join();
+    }
+}
+
+void AuthManager::refreshLoop() {
+    // Renew well before expiry so requests never see a dead token; back off on failure
+    constexpr auto lead = std::chrono::minutes(5);
+    constexpr auto maxBackoff = std::chrono::minutes(5);
+    std::chrono::seconds backoff(30);
+
+    std::unique_lock<std::mutex> lock(pImpl_->scheduleMutex);
+    auto due = getTokens().expiry() - lead;
+
+    while (pImpl_->autoRefresh) {
+        if (pImpl_->scheduleCv.wait_until(lock, due, [this]() { return !pImpl_->autoRefresh; })) {
+            break;
+        }
+
+        // Someone else (a 401 retry) may have refreshed in the meantime
+        const AuthTokens seen = getTokens();
+        const auto current = seen.expiry() - lead;
+        if (current > std::chrono::system_clock::now()) {
+            due = current;
+            continue;
+        }
+
+        lock.unlock();
+        Log::stream(LogLevel::INFO) << "Access token expires soon, refreshing in background" << std::endl;
+        const bool refreshed = !refreshNow(seen.accessToken).empty();
+        lock.lock();
+
+        if (refreshed) {
+            backoff = std::chrono::seconds(30);
+            due = getTokens().expiry() - lead;
+        } else {
+            Log::stream(LogLevel::WARN) << "Background token refresh failed, retrying in " << backoff.count() << "s" << std::endl;
+            due = std::chrono::system_clock::now() + backoff;
+            backoff = std::min<std::chrono::seconds>(backoff * 2, maxBackoff);
+        }
     }
 }
 
 std::string AuthManager::buildAuthUrl() const {
-    const std::string encodedScope = "user-read-currently-playing%20user-modify-playback-state";
+    const std::string encodedScope = "user-read-currently-playing%20user-read-playback-state%20user-modify-playback-state";
     const std::string encodedRedirect = "http%3A%2F%2F127.0.0.1%3A8888%2Fcallback";
 
-    std::string url = "https://accounts.spotify.com/authorize?response_type=code&client_id=" + clientId_ +
+    std::string url = accountsUrl_ + "/authorize?response_type=code&client_id=" + clientId_ +
                      "&scope=" + encodedScope +
                      "&redirect_uri=" + encodedRedirect;
 
-    std::cout << "Built auth URL (scope: " << encodedScope << ")" << std::endl;
+    Log::stream(LogLevel::INFO) << "Built auth URL (scope: " << encodedScope << ")" << std::endl;
     return url;
 }
 
 bool AuthManager::exchangeCodeForTokens(const std::string& code) {
     try {
-        std::cout << "Exchanging code for tokens..." << std::endl;
+        Log::stream(LogLevel::INFO) << "Exchanging code for tokens..." << std::endl;
 
-        http_client client(U("https://accounts.spotify.com"));
+        http_client client(accountsUrl_);
         http_request request(methods::POST);
 
         request.set_request_uri(U("/api/token"));
@@ -229,31 +475,34 @@ bool AuthManager::exchangeCodeForTokens(const std::string& code) {
                                 "&client_id=" + clientId_ +
                                 "&client_secret=" + clientSecret_;
 
-        std::cout << "Sending token exchange request..." << std::endl;
+        Log::stream(LogLevel::INFO) << "Sending token exchange request..." << std::endl;
         request.set_body(body, "application/x-www-form-urlencoded");
 
-        const auto response = client.request(request).get();
-        std::cout << "Token exchange response status: " << response.status_code() << std::endl;
+        const auto response = sendTokenRequest(client, request);
+        Log::stream(LogLevel::INFO) << "Token exchange response status: " << response.status_code() << std::endl;
 
         if (response.status_code() != status_codes::OK) {
-            std::cerr << "Token exchange failed with status: " << response.status_code() << std::endl;
+            Log::stream(LogLevel::ERROR) << "Token exchange failed with status: " << response.status_code() << std::endl;
             return false;
         }
 
         auto json = response.extract_json().get();
-        tokens_.accessToken = json[U("access_token")].as_string();
-        tokens_.refreshToken = json[U("refresh_token")].as_string();
-        tokens_.lastUpdate = std::chrono::system_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(tokensMutex_);
+            tokens_.accessToken = json[U("access_token")].as_string();
+            tokens_.refreshToken = json[U("refresh_token")].as_string();
+            tokens_.lastUpdate = std::chrono::system_clock::now();
+            tokens_.expiresAt = tokens_.lastUpdate + std::chrono::seconds(
+                json.has_field(U("expires_in")) ? json[U("expires_in")].as_integer() : 3600);
+        }
 
-        std::cout << "Token exchange successful!" << std::endl;
+        Log::stream(LogLevel::INFO) << "Token exchange successful!" << std::endl;
 
-        if (authCallback_) {
-            authCallback_(tokens_);
-        }
+        publishTokens();
 
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Token exchange error: " << e.what() << std::endl;
+        Log::stream(LogLevel::ERROR) << "Token exchange error: " << e.what() << std::endl;
         return false;
     }
 }
\ No newline at end of file
@@ -3,46 +3,239 @@
 //
 
 #include "../include/ConfigManager.h"
+#include "../include/Log.h"
 #include <fstream>
 #include <filesystem>
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
 
 using json = nlohmann::json;
 
+namespace {
+    // Out-of-range or unparsable values keep the setting that is already live
+    template <typename T>
+    T number(const std::map<std::string, std::string>& values, const std::string& key, T previous,
+             int64_t min, int64_t max) {
+        const auto it = values.find(key);
+        if (it == values.end()) return previous;
+
+        int64_t value;
+        try {
+            value = std::stoll(it->second);
+        } catch (const std::exception&) {
+            Log::stream(LogLevel::WARN) << "Ignoring invalid value for " << key << ": " << it->second << std::endl;
+            return previous;
+        }
+
+        if (value < min || value > max) {
+            Log::stream(LogLevel::WARN) << "Ignoring out-of-range value for " << key << ": " << value
+                                        << " (allowed " << min << ".." << max << ")" << std::endl;
+            return previous;
+        }
+        return static_cast<T>(value);
+    }
+
+    LogLevel parseLogLevel(const std::string& value, LogLevel fallback) {
+        if (value == "error") return LogLevel::ERROR;
+        if (value == "warn") return LogLevel::WARN;
+        if (value == "info") return LogLevel::INFO;
+        if (value == "debug") return LogLevel::DEBUG;
+        return fallback;
+    }
+
+    const char* logLevelName(LogLevel level) {
+        switch (level) {
+            case LogLevel::ERROR: return "error";
+            case LogLevel::WARN: return "warn";
+            case LogLevel::INFO: return "info";
+            case LogLevel::DEBUG: return "debug";
+        }
+        return "info";
+    }
+}
+
 ConfigManager &ConfigManager::getInstance() {
     static ConfigManager instance;
     return instance;
 }
 
+ConfigManager::~ConfigManager() {
+    stopWatching();
+}
+
 bool ConfigManager::loadConfig() {
     try {
-        std::ifstream file(configPath_);
-        if (!file.is_open()) {
+        std::map<std::string, std::string> values;
+        if (!readConfig(values)) {
             clientId_ = "you_clinet_id";
             clientSecret_ = "you_client_secret";
             return saveConfig();
         }
 
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.empty() || line[0] == '#') continue;
+        if (const auto it = values.find("client.id"); it != values.end()) clientId_ = it->second;
+        if (const auto it = values.find("client.secret"); it != values.end()) clientSecret_ = it->second;
+        if (const auto it = values.find("api.base_url"); it != values.end()) apiBaseUrl_ = it->second;
+        if (const auto it = values.find("accounts.base_url"); it != values.end()) accountsBaseUrl_ = it->second;
 
-            size_t pos = line.find('=');
-            if (pos != std::string::npos) {
-                std::string key = line.substr(0, pos);
-                std::string value = line.substr(pos + 1);
+        std::lock_guard<std::mutex> lock(settingsMutex_);
+        settings_ = parseSettings(values, settings_);
+        return true;
+    } catch (const std::exception& e) {
+        Log::stream(LogLevel::ERROR) << e.what() << std::endl;
+        return false;
+    }
+}
 
-                if (key == "client.id") clientId_ = value;
-                else if (key == "client.secret") clientSecret_ = value;
-            }
+bool ConfigManager::readConfig(std::map<std::string, std::string>& values) const {
+    std::ifstream file(configPath_);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t pos = line.find('=');
+        if (pos != std::string::npos) {
+            values[line.substr(0, pos)] = line.substr(pos + 1);
         }
+    }
+    return true;
+}
 
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+PerformanceSettings ConfigManager::parseSettings(const std::map<std::string, std::string>& values,
+                                                 const PerformanceSettings& previous) {
+    constexpr int64_t minute = 60 * 1000;
+    constexpr int64_t hour = 60 * minute;
+
+    PerformanceSettings settings;
+    auto& polling = settings.polling;
+    const auto& was = previous.polling;
+
+    // The floor keeps the poll loop from leaning on the rate limiter alone
+    polling.minInterval = std::chrono::milliseconds(number(values, "poll.min_ms", was.minInterval.count(), 500, 10 * minute));
+    polling.maxInterval = std::chrono::milliseconds(number(values, "poll.max_ms", was.maxInterval.count(), 500, hour));
+    polling.pausedInterval = std::chrono::milliseconds(number(values, "poll.paused_ms", was.pausedInterval.count(), 500, hour));
+    polling.idleInterval = std::chrono::milliseconds(number(values, "poll.idle_ms", was.idleInterval.count(), 500, hour));
+    polling.deepIdleAfter = std::chrono::milliseconds(number(values, "poll.deep_idle_ms", was.deepIdleAfter.count(), minute, 24 * hour));
+    polling.maxInterval = std::max(polling.maxInterval, polling.minInterval);
+
+    settings.prefetch.lookahead = number(values, "prefetch.lookahead", previous.prefetch.lookahead, 0, 20);
+    settings.workerThreads = number(values, "workers.threads", previous.workerThreads, 1, 8);
+    settings.workerQueue = number(values, "workers.queue", previous.workerQueue, 1, 256);
+    settings.artMemoryEntries = number(values, "art.memory_entries", previous.artMemoryEntries, 0, 1024);
+    settings.artDiskBytes = number<int64_t>(values, "art.disk_mb", previous.artDiskBytes / (1024 * 1024), 0, 4096) * 1024 * 1024;
+    settings.requestTimeout = std::chrono::seconds(number(values, "http.timeout_s", previous.requestTimeout.count(), 1, 120));
+    settings.logLevel = previous.logLevel;
+
+    if (const auto it = values.find("log.level"); it != values.end()) {
+        settings.logLevel = parseLogLevel(it->second, settings.logLevel);
+    }
+
+    return settings;
+}
+
+PerformanceSettings ConfigManager::getPerformanceSettings() const {
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    return settings_;
+}
+
+void ConfigManager::addSettingsListener(const SettingsListener& listener) {
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    listeners_.push_back(listener);
+}
+
+void ConfigManager::reloadSettings() {
+    std::map<std::string, std::string> values;
+    if (!readConfig(values)) return;
+
+    const PerformanceSettings settings = parseSettings(values, getPerformanceSettings());
+    std::vector<SettingsListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex_);
+        settings_ = settings;
+        listeners = listeners_;
+    }
+
+    Log::stream(LogLevel::INFO) << "Configuration reloaded" << std::endl;
+    for (const auto& listener : listeners) {
+        listener(settings);
+    }
+}
+
+bool ConfigManager::startWatching() {
+    if (watchThread_.joinable()) return true;
+
+    const int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        Log::stream(LogLevel::WARN) << "Failed to initialise inotify, config reload disabled" << std::endl;
+        return false;
+    }
+
+    // Watch the directory: editors usually replace the file instead of rewriting it
+    std::string directory = std::filesystem::path(configPath_).parent_path().string();
+    if (directory.empty()) directory = ".";
+
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        pipe(stopFds_) != 0) {
+        Log::stream(LogLevel::WARN) << "Failed to watch " << configPath_ << ", config reload disabled" << std::endl;
+        close(inotifyFd);
         return false;
     }
+
+    watchThread_ = std::thread([this, inotifyFd]() { watchLoop(inotifyFd); });
+    Log::stream(LogLevel::INFO) << "Watching " << configPath_ << " for changes" << std::endl;
+    return true;
+}
+
+void ConfigManager::stopWatching() {
+    if (!watchThread_.joinable()) return;
+
+    const char byte = 1;
+    [[maybe_unused]] const auto written = write(stopFds_[1], &byte, 1);
+    watchThread_.join();
+
+    close(stopFds_[0]);
+    close(stopFds_[1]);
+    stopFds_[0] = stopFds_[1] = -1;
+}
+
+void ConfigManager::watchLoop(int inotifyFd) {
+    const std::string fileName = std::filesystem::path(configPath_).filename().string();
+    alignas(inotify_event) char buffer[4096];
+
+    pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFds_[0], POLLIN, 0}};
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (char* ptr = buffer; ptr < buffer + length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+                if (event->len > 0 && fileName == event->name) {
+                    changed = true;
+                }
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        if (changed) {
+            reloadSettings();
+        }
+    }
+
+    close(inotifyFd);
 }
 
 bool ConfigManager::saveConfig() const {
@@ -53,10 +246,27 @@ bool ConfigManager::saveConfig() const {
         file << "# Spotify API Configuration\n";
         file << "client.id=" << clientId_ << "\n";
         file << "client.secret=" << clientSecret_ << "\n";
+        file << "api.base_url=" << apiBaseUrl_ << "\n";
+        file << "accounts.base_url=" << accountsBaseUrl_ << "\n";
+
+        const PerformanceSettings settings = getPerformanceSettings();
+        file << "\n# Performance (applied live when this file changes)\n";
+        file << "poll.min_ms=" << settings.polling.minInterval.count() << "\n";
+        file << "poll.max_ms=" << settings.polling.maxInterval.count() << "\n";
+        file << "poll.paused_ms=" << settings.polling.pausedInterval.count() << "\n";
+        file << "poll.idle_ms=" << settings.polling.idleInterval.count() << "\n";
+        file << "poll.deep_idle_ms=" << settings.polling.deepIdleAfter.count() << "\n";
+        file << "prefetch.lookahead=" << settings.prefetch.lookahead << "\n";
+        file << "workers.threads=" << settings.workerThreads << "\n";
+        file << "workers.queue=" << settings.workerQueue << "\n";
+        file << "art.memory_entries=" << settings.artMemoryEntries << "\n";
+        file << "art.disk_mb=" << settings.artDiskBytes / (1024 * 1024) << "\n";
+        file << "http.timeout_s=" << settings.requestTimeout.count() << "\n";
+        file << "log.level=" << logLevelName(settings.logLevel) << "\n";
 
         return true;
     } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+        Log::stream(LogLevel::ERROR) << e.what() << std::endl;
         return false;
     }
 }
@@ -75,9 +285,13 @@ bool ConfigManager::loadTokens(AuthTokens &tokens) const {
         const auto lastUpdated = j.value("last_updated", 0);
         tokens.lastUpdate = std::chrono::system_clock::from_time_t(lastUpdated);
 
+        if (const auto expiresAt = j.value("expires_at", std::time_t{0}); expiresAt != 0) {
+            tokens.expiresAt = std::chrono::system_clock::from_time_t(expiresAt);
+        }
+
         return tokens.isValid();
     } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+        Log::stream(LogLevel::ERROR) << e.what() << std::endl;
         return false;
     }
 }
@@ -88,6 +302,7 @@ bool ConfigManager::saveTokens(const AuthTokens &tokens) {
         j["access_token"] = tokens.accessToken;
         j["refresh_token"] = tokens.refreshToken;
         j["last_updated"] = std::chrono::system_clock::to_time_t(tokens.lastUpdate);
+        j["expires_at"] = std::chrono::system_clock::to_time_t(tokens.expiry());
 
         std::ofstream file(tokensPath_);
         if (!file.is_open()) return false;
@@ -96,7 +311,7 @@ bool ConfigManager::saveTokens(const AuthTokens &tokens) {
 
         return true;
     } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+        Log::stream(LogLevel::ERROR) << e.what() << std::endl;
         return false;
     }
 }
@@ -106,7 +321,7 @@ void ConfigManager::setCredentials(const std::string &clientId, const std::strin
     clientSecret_ = clientSecret;
 
     if (!saveConfig()) {
-        std::cerr << "ERROR::CONFIGMANAGER::CONFIG_SAVE_ERROR" << std::endl;
+        Log::stream(LogLevel::ERROR) << "ERROR::CONFIGMANAGER::CONFIG_SAVE_ERROR" << std::endl;
     }
 }
 
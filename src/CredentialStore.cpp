@@ -0,0 +1,49 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/CredentialStore.h"
+
+#include <thread>
+
+namespace {
+    struct ReaderSlot {
+        std::atomic<int>& count;
+        ~ReaderSlot() { count.fetch_sub(1); }
+    };
+}
+
+CredentialStore::~CredentialStore() {
+    delete current_.load();
+}
+
+Credential CredentialStore::current() const {
+    // Retry if a publish moved the epoch before this reader was counted in it
+    uint64_t epoch = epoch_.load();
+    while (true) {
+        readers_[epoch & 1].fetch_add(1);
+        const uint64_t now = epoch_.load();
+        if (now == epoch) break;
+        readers_[epoch & 1].fetch_sub(1);
+        epoch = now;
+    }
+
+    ReaderSlot slot{readers_[epoch & 1]};
+    const Credential* snapshot = current_.load();
+    return snapshot ? *snapshot : Credential{};
+}
+
+Credential CredentialStore::publish(const std::string& token) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+
+    const auto* snapshot = new const Credential{token, "Bearer " + token, ++generation_};
+    const Credential* replaced = current_.exchange(snapshot);
+    const uint64_t epoch = epoch_.fetch_add(1);
+
+    // Readers counted in the old epoch may still be copying the replaced snapshot
+    while (readers_[epoch & 1].load() != 0) {
+        std::this_thread::yield();
+    }
+    delete replaced;
+    return *snapshot;
+}
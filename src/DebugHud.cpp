@@ -0,0 +1,74 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/DebugHud.h"
+#include "../include/Metrics.h"
+#include <QFontDatabase>
+#include <QVBoxLayout>
+
+namespace {
+    const char* const Spans[] = {
+        "update_track_info",
+        "paint",
+        "image_downloaded",
+        "callback_queue_delay",
+    };
+}
+
+DebugHud::DebugHud(QWidget *parent) : QWidget(parent) {
+    setWindowFlags(Qt::WindowStaysOnTopHint |
+                   Qt::Tool |
+                   Qt::X11BypassWindowManagerHint);
+    setAttribute(Qt::WA_ShowWithoutActivating);
+    setAttribute(Qt::WA_StyledBackground);
+
+    setStyleSheet(R"(
+        DebugHud {
+            background: #141414;
+        }
+        QLabel {
+            color: #b0b0b0;
+            font-size: 11px;
+        }
+    )");
+
+    label_ = new QLabel(this);
+    label_->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(8, 8, 8, 8);
+    layout->addWidget(label_);
+
+    refreshTimer_.setInterval(1000);
+    connect(&refreshTimer_, &QTimer::timeout, this, &DebugHud::refresh);
+}
+
+void DebugHud::showEvent(QShowEvent *event) {
+    refresh();
+    refreshTimer_.start();
+    QWidget::showEvent(event);
+}
+
+void DebugHud::hideEvent(QHideEvent *event) {
+    refreshTimer_.stop();
+    QWidget::hideEvent(event);
+}
+
+void DebugHud::refresh() {
+    QString text = QStringLiteral("%1 %2 %3 %4 %5\n")
+        .arg("span", -22).arg("p50 ms", 8).arg("p99 ms", 8).arg("max ms", 8).arg("/s", 6);
+
+    for (const char* name : Spans) {
+        const SpanStats stats = Metrics::getInstance().spanStats(name);
+        text += QStringLiteral("%1 %2 %3 %4 %5\n")
+            .arg(name, -22)
+            .arg(stats.p50Micros / 1000.0, 8, 'f', 2)
+            .arg(stats.p99Micros / 1000.0, 8, 'f', 2)
+            .arg(stats.maxMicros / 1000.0, 8, 'f', 2)
+            .arg(stats.ratePerSecond, 6, 'f', 1);
+    }
+
+    label_->setText(text.trimmed());
+    adjustSize();
+}
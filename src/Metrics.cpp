@@ -0,0 +1,287 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/Metrics.h"
+#include "../include/Log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+void LatencyHistogram::record(uint64_t value) {
+    ++buckets_[indexFor(value)];
+    ++count_;
+    sum_ += value;
+    max_ = std::max(max_, value);
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (count_ == 0) return 0;
+
+    const auto target = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count_)));
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        seen += buckets_[i];
+        if (seen >= std::max<uint64_t>(target, 1)) {
+            return std::min(highestValueAt(i), max_);
+        }
+    }
+    return max_;
+}
+
+size_t LatencyHistogram::indexFor(uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+
+    const int msb = 63 - __builtin_clzll(value);
+    const int magnitude = msb - SUB_BUCKET_BITS + 1;
+    if (magnitude >= MAGNITUDES) return MAGNITUDES * SUB_BUCKETS - 1;
+
+    const auto sub = (value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>(magnitude * SUB_BUCKETS) + sub;
+}
+
+uint64_t LatencyHistogram::highestValueAt(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+
+    const auto magnitude = index / SUB_BUCKETS;
+    const auto sub = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (magnitude - 1)) - 1;
+}
+
+void RollingStats::record(uint64_t value, std::chrono::steady_clock::time_point at) {
+    values_[next_] = value;
+    times_[next_] = at;
+    next_ = (next_ + 1) % WINDOW;
+    size_ = std::min(size_ + 1, WINDOW);
+}
+
+SpanStats RollingStats::snapshot(std::chrono::steady_clock::time_point now) const {
+    SpanStats stats;
+    if (size_ == 0) return stats;
+
+    std::array<uint64_t, WINDOW> sorted{};
+    std::copy_n(values_.begin(), size_, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(size_));
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size_; ++i) sum += sorted[i];
+
+    const auto at = [&](double fraction) {
+        return sorted[std::min(size_ - 1, static_cast<size_t>(fraction * static_cast<double>(size_)))];
+    };
+
+    stats.count = size_;
+    stats.meanMicros = static_cast<double>(sum) / static_cast<double>(size_);
+    stats.p50Micros = at(0.5);
+    stats.p99Micros = at(0.99);
+    stats.maxMicros = sorted[size_ - 1];
+
+    // Oldest sample still in the window
+    const auto oldest = times_[size_ < WINDOW ? 0 : next_];
+    const auto span = std::chrono::duration<double>(now - oldest).count();
+    stats.ratePerSecond = span > 0 ? static_cast<double>(size_) / span : 0;
+
+    return stats;
+}
+
+Metrics& Metrics::getInstance() {
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::~Metrics() {
+    stopDumping();
+}
+
+void Metrics::recordRequest(const std::string& endpoint, std::chrono::microseconds latency, int statusCode) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& metrics = endpoints_[endpoint];
+        metrics.latency.record(static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)));
+        ++metrics.statusCodes[statusCode];
+    }
+    markDirty();
+}
+
+void Metrics::recordBytes(const std::string& endpoint, uint64_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        endpoints_[endpoint].bytes += bytes;
+    }
+    markDirty();
+}
+
+void Metrics::recordRetry(const std::string& endpoint) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++endpoints_[endpoint].retries;
+    }
+    markDirty();
+}
+
+void Metrics::recordSpan(const std::string& name, std::chrono::microseconds duration, bool wakeDumper) {
+    const auto micros = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& span = spans_[name];
+        span.total.record(micros);
+        span.recent.record(micros, std::chrono::steady_clock::now());
+    }
+    if (wakeDumper) {
+        markDirty();
+    }
+}
+
+SpanStats Metrics::spanStats(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = spans_.find(name);
+    if (it == spans_.end()) return SpanStats{};
+    return it->second.recent.snapshot(std::chrono::steady_clock::now());
+}
+
+SpanStats Metrics::requestStats(const std::string& endpoint) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = endpoints_.find(endpoint);
+    if (it == endpoints_.end()) return SpanStats{};
+
+    // Cumulative over the whole run, unlike the rolling span window
+    const auto& latency = it->second.latency;
+    SpanStats stats;
+    stats.count = latency.count();
+    stats.meanMicros = latency.count() ? static_cast<double>(latency.sum()) / static_cast<double>(latency.count()) : 0;
+    stats.p50Micros = latency.percentile(0.5);
+    stats.p99Micros = latency.percentile(0.99);
+    stats.maxMicros = latency.max();
+    return stats;
+}
+
+bool Metrics::startDumping(const std::string& path, std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dumpThread_.joinable()) {
+        Log::stream(LogLevel::WARN) << "Metrics dump already running" << std::endl;
+        return false;
+    }
+
+    dumpPath_ = path;
+    dumpInterval_ = std::max(interval, std::chrono::seconds(1));
+    stopping_ = false;
+    dumpThread_ = std::thread([this]() { dumpLoop(); });
+
+    Log::stream(LogLevel::INFO) << "Writing metrics to " << path << " every " << dumpInterval_.count() << " seconds" << std::endl;
+    return true;
+}
+
+void Metrics::stopDumping() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    dumpCv_.notify_all();
+
+    if (dumpThread_.joinable()) {
+        dumpThread_.join();
+    }
+}
+
+std::string Metrics::renderPrometheus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6);
+
+    const auto seconds = [](uint64_t micros) { return static_cast<double>(micros) / 1e6; };
+
+    out << "# TYPE spotify_request_latency_seconds summary\n";
+    for (const auto& [endpoint, metrics] : endpoints_) {
+        const auto& latency = metrics.latency;
+        for (const auto& [label, quantile] : {std::pair{"0.5", 0.5}, std::pair{"0.9", 0.9}, std::pair{"0.99", 0.99}}) {
+            out << "spotify_request_latency_seconds{endpoint=\"" << endpoint << "\",quantile=\"" << label << "\"} "
+                << seconds(latency.percentile(quantile)) << "\n";
+        }
+        out << "spotify_request_latency_seconds_sum{endpoint=\"" << endpoint << "\"} " << seconds(latency.sum()) << "\n";
+        out << "spotify_request_latency_seconds_count{endpoint=\"" << endpoint << "\"} " << latency.count() << "\n";
+    }
+
+    out << "# TYPE spotify_request_latency_max_seconds gauge\n";
+    for (const auto& [endpoint, metrics] : endpoints_) {
+        out << "spotify_request_latency_max_seconds{endpoint=\"" << endpoint << "\"} "
+            << seconds(metrics.latency.max()) << "\n";
+    }
+
+    out << "# TYPE spotify_requests_total counter\n";
+    for (const auto& [endpoint, metrics] : endpoints_) {
+        for (const auto& [code, count] : metrics.statusCodes) {
+            out << "spotify_requests_total{endpoint=\"" << endpoint << "\",code=\"" << code << "\"} " << count << "\n";
+        }
+    }
+
+    out << "# TYPE spotify_request_retries_total counter\n";
+    for (const auto& [endpoint, metrics] : endpoints_) {
+        out << "spotify_request_retries_total{endpoint=\"" << endpoint << "\"} " << metrics.retries << "\n";
+    }
+
+    out << "# TYPE spotify_response_bytes_total counter\n";
+    for (const auto& [endpoint, metrics] : endpoints_) {
+        out << "spotify_response_bytes_total{endpoint=\"" << endpoint << "\"} " << metrics.bytes << "\n";
+    }
+
+    out << "# TYPE spotify_gui_span_seconds summary\n";
+    for (const auto& [name, span] : spans_) {
+        for (const auto& [label, quantile] : {std::pair{"0.5", 0.5}, std::pair{"0.9", 0.9}, std::pair{"0.99", 0.99}}) {
+            out << "spotify_gui_span_seconds{span=\"" << name << "\",quantile=\"" << label << "\"} "
+                << seconds(span.total.percentile(quantile)) << "\n";
+        }
+        out << "spotify_gui_span_seconds_sum{span=\"" << name << "\"} " << seconds(span.total.sum()) << "\n";
+        out << "spotify_gui_span_seconds_count{span=\"" << name << "\"} " << span.total.count() << "\n";
+    }
+
+    return out.str();
+}
+
+void Metrics::markDirty() {
+    bool wasClean;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wasClean = !dirty_;
+        dirty_ = true;
+    }
+    if (wasClean) {
+        dumpCv_.notify_all();
+    }
+}
+
+void Metrics::dumpLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stopping_) {
+        // Sleep until there is something new, so an idle overlay does not wake up
+        dumpCv_.wait(lock, [this]() { return dirty_ || stopping_; });
+        if (stopping_) break;
+
+        dumpCv_.wait_for(lock, dumpInterval_, [this]() { return stopping_; });
+        dirty_ = false;
+
+        lock.unlock();
+        if (!writeDump()) {
+            Log::stream(LogLevel::ERROR) << "Failed to write metrics to " << dumpPath_ << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+bool Metrics::writeDump() const {
+    const std::string tmpPath = dumpPath_ + ".tmp";
+    {
+        std::ofstream file(tmpPath);
+        if (!file.is_open()) return false;
+        file << renderPrometheus();
+    }
+    return std::rename(tmpPath.c_str(), dumpPath_.c_str()) == 0;
+}
@@ -0,0 +1,145 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/PlaybackState.h"
+#include <algorithm>
+
+PlaybackState::PlaybackState(std::chrono::milliseconds confirmTimeout)
+    : confirmTimeout_(confirmTimeout) {}
+
+PlayBackAction PlaybackState::resolve(PlayBackAction action) const {
+    if (action != PlayBackAction::TOGGLE) return action;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return effectiveLocked().isPlaying ? PlayBackAction::PAUSE : PlayBackAction::PLAY;
+}
+
+uint64_t PlaybackState::apply(PlayBackAction action) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const uint64_t id = nextId_++;
+    pending_.push_back(PendingCommand{id, action, effectiveLocked().id,
+                                      std::chrono::steady_clock::now(), false});
+    return id;
+}
+
+void PlaybackState::acknowledge(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (auto& command : pending_) {
+        if (command.id == id) {
+            command.acknowledged = true;
+            command.issuedAt = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+void PlaybackState::reject(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [id](const PendingCommand& command) { return command.id == id; }),
+                   pending_.end());
+}
+
+void PlaybackState::reconcile(const SpotifyTrack& snapshot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    confirmed_ = snapshot;
+
+    const auto reached = std::find_if(upcoming_.begin(), upcoming_.end(),
+                                      [&snapshot](const SpotifyTrack& track) { return track.id == snapshot.id; });
+    if (reached != upcoming_.end()) {
+        upcoming_.erase(upcoming_.begin(), reached + 1);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [&](const PendingCommand& command) {
+                                      if (now - command.issuedAt > confirmTimeout_) return true;
+                                      return command.acknowledged && isReflectedBy(command, snapshot);
+                                  }),
+                   pending_.end());
+}
+
+void PlaybackState::setUpcoming(const std::vector<SpotifyTrack>& upcoming) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    upcoming_ = upcoming;
+}
+
+SpotifyTrack PlaybackState::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return effectiveLocked();
+}
+
+bool PlaybackState::hasPending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !pending_.empty();
+}
+
+SpotifyTrack PlaybackState::effectiveLocked() const {
+    SpotifyTrack track = confirmed_;
+    size_t skipped = 0;
+
+    for (const auto& command : pending_) {
+        advance(track, command.issuedAt);
+
+        switch (command.action) {
+            case PlayBackAction::PLAY:
+                track.isPlaying = true;
+                break;
+            case PlayBackAction::PAUSE:
+                track.isPlaying = false;
+                break;
+            case PlayBackAction::NEXT:
+                if (skipped < upcoming_.size()) {
+                    track = upcoming_[skipped++];
+                    track.fetchedAt = command.issuedAt;
+                }
+                track.isPlaying = true;
+                track.progressMs = 0;
+                break;
+            case PlayBackAction::PREVIOUS:
+                track.isPlaying = true;
+                track.progressMs = 0;
+                break;
+            case PlayBackAction::TOGGLE:
+                track.isPlaying = !track.isPlaying;
+                break;
+        }
+    }
+
+    return track;
+}
+
+void PlaybackState::advance(SpotifyTrack& track, std::chrono::steady_clock::time_point at) {
+    // Moves the progress anchor to `at` so later commands start from the right position
+    if (at <= track.fetchedAt) return;
+
+    if (track.isPlaying && track.fetchedAt.time_since_epoch().count() != 0) {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(at - track.fetchedAt);
+        track.progressMs += static_cast<int>(elapsed.count());
+        if (track.durationMs > 0) {
+            track.progressMs = std::min(track.progressMs, track.durationMs);
+        }
+    }
+    track.fetchedAt = at;
+}
+
+bool PlaybackState::isReflectedBy(const PendingCommand& command, const SpotifyTrack& snapshot) {
+    switch (command.action) {
+        case PlayBackAction::PLAY:
+            return snapshot.isPlaying;
+        case PlayBackAction::PAUSE:
+            return !snapshot.isPlaying;
+        case PlayBackAction::NEXT:
+            return snapshot.id != command.fromTrackId;
+        case PlayBackAction::PREVIOUS:
+            // "previous" may legitimately restart the same track
+            return snapshot.id != command.fromTrackId || snapshot.progressMs < 3000;
+        case PlayBackAction::TOGGLE:
+            return true;
+    }
+    return true;
+}
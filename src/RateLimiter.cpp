@@ -0,0 +1,82 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/RateLimiter.h"
+#include "../include/Log.h"
+#include <algorithm>
+#include <iostream>
+
+RateLimiter::RateLimiter(double capacity, double refillPerSecond, double commandReserve)
+    : capacity_(capacity),
+      refillPerSecond_(refillPerSecond),
+      commandReserve_(std::min(commandReserve, capacity)),
+      tokens_(capacity),
+      lastRefill_(std::chrono::steady_clock::now()),
+      blockedUntil_() {}
+
+bool RateLimiter::tryAcquire(TaskKind kind) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto now = std::chrono::steady_clock::now();
+    refill(now);
+
+    double floor = commandReserve_;
+    if (kind == TaskKind::COMMAND) floor = 0.0;
+    else if (kind == TaskKind::PREFETCH) floor = std::max(commandReserve_, capacity_ / 2);
+
+    if (now < blockedUntil_ || tokens_ - 1.0 < floor) {
+        ++stats_.denied;
+        return false;
+    }
+
+    tokens_ -= 1.0;
+    ++stats_.granted;
+    return true;
+}
+
+void RateLimiter::onRetryAfter(std::chrono::seconds delay) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto until = std::chrono::steady_clock::now() + delay;
+    blockedUntil_ = std::max(blockedUntil_, until);
+    tokens_ = 0.0;
+    ++stats_.throttled;
+
+    Log::stream(LogLevel::WARN) << "Rate limited by server, backing off for " << delay.count() << " seconds" << std::endl;
+}
+
+std::chrono::milliseconds RateLimiter::blockedFor() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= blockedUntil_) return std::chrono::milliseconds(0);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(blockedUntil_ - now);
+}
+
+RateLimitStats RateLimiter::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    RateLimitStats stats = stats_;
+    const auto now = std::chrono::steady_clock::now();
+
+    stats.tokens = tokensAt(now);
+    stats.capacity = capacity_;
+    if (now < blockedUntil_) {
+        stats.retryAfter = std::chrono::duration_cast<std::chrono::milliseconds>(blockedUntil_ - now);
+    }
+    return stats;
+}
+
+double RateLimiter::tokensAt(std::chrono::steady_clock::time_point now) const {
+    const auto from = std::max(lastRefill_, blockedUntil_);
+    if (now <= from) return tokens_;
+
+    const std::chrono::duration<double> elapsed = now - from;
+    return std::min(capacity_, tokens_ + elapsed.count() * refillPerSecond_);
+}
+
+void RateLimiter::refill(std::chrono::steady_clock::time_point now) {
+    tokens_ = tokensAt(now);
+    lastRefill_ = std::max(lastRefill_, now);
+}
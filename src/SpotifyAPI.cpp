@@ -3,280 +3,807 @@
 //
 
 #include "../include/SpotifyAPI.h"
+#include "../include/RateLimiter.h"
+#include "../include/TrackParser.h"
+#include "../include/Metrics.h"
+#include "../include/PlaybackState.h"
+#include "../include/Log.h"
+#include "../include/CredentialStore.h"
 #include <cpprest/http_client.h>
 #include <cpprest/json.h>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <vector>
+#include <utility>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <cstdlib>
 
 using namespace web;
 using namespace web::http;
 using namespace web::http::client;
 
+namespace {
+    struct ConnectionCounters {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> handshakes{0};
+    };
+
+    http_client_config makeClientConfig(const std::shared_ptr<ConnectionCounters>& counters,
+                                        std::chrono::seconds timeout) {
+        http_client_config config;
+        config.set_timeout(timeout);
+
+        // Only invoked when the pool has to open a new TLS connection
+        config.set_ssl_context_callback([counters](boost::asio::ssl::context&) {
+            ++counters->handshakes;
+        });
+
+        return config;
+    }
+
+    std::chrono::microseconds elapsedSince(std::chrono::steady_clock::time_point started) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+    }
+
+    std::chrono::seconds parseRetryAfter(const http_response& response) {
+        const auto header = response.headers().find("Retry-After");
+        if (header != response.headers().end()) {
+            try {
+                return std::chrono::seconds(std::max(std::stoi(header->second), 1));
+            } catch (const std::exception&) {
+                // Fall through to the default back-off
+            }
+        }
+        return std::chrono::seconds(5);
+    }
+
+    TrackChanges diffTracks(const SpotifyTrack& previous, const SpotifyTrack& current) {
+        TrackChanges changes;
+        changes.track = previous.id != current.id ||
+                        (current.id.empty() && previous.name != current.name);
+        changes.playState = previous.isPlaying != current.isPlaying;
+        changes.artwork = previous.imageUrl != current.imageUrl;
+
+        // Only a seek or a drifting clock makes the position worth redelivering
+        auto expected = static_cast<int64_t>(previous.progressMs);
+        if (previous.isPlaying && current.fetchedAt > previous.fetchedAt) {
+            expected += std::chrono::duration_cast<std::chrono::milliseconds>(current.fetchedAt - previous.fetchedAt).count();
+        }
+        changes.progress = previous.durationMs != current.durationMs ||
+                           std::abs(current.progressMs - expected) > 1500;
+        return changes;
+    }
+}
+
 class SpotifyAPI::Impl {
 public:
-    std::string accessToken;
+    CredentialStore credentials;
+    std::mutex refreshMutex;
+    TokenRefresher tokenRefresher_;
     std::atomic<bool> polling{false};
     std::thread pollingThread;
-    TrackCallback trackCallback_;
+
+    std::mutex scheduleMutex;
+    std::condition_variable scheduleCv;
+    std::chrono::steady_clock::time_point nextPollAt;
+    std::chrono::steady_clock::time_point notPlayingSince;
+    std::chrono::steady_clock::time_point pollFreshAfter;
+    bool suspended = false;
+    PollingConfig pollingConfig;
+    TrackChangeCallback trackCallback_;
     ErrorCallback errorCallback_;
+    QueueCallback queueCallback_;
+
+    struct FetchWaiter {
+        TrackCallback success;
+        ErrorCallback error;
+    };
+
+    // A fetch is fresh for callers whose state changed before it was sent;
+    // later callers wait for one follow-up fetch instead.
+    std::mutex fetchMutex;
+    bool fetchInFlight = false;
+    bool followUpQueued = false;
+    std::chrono::steady_clock::time_point fetchSentAt;
+    std::vector<FetchWaiter> fetchWaiters;
+    std::vector<FetchWaiter> followUpWaiters;
+    std::atomic<uint64_t> coalescedFetches{0};
+
+    // Only touched by the single in-flight currently-playing fetch
+    TrackParser parser;
+    std::atomic<int> artworkSize{64};
+
+    PlaybackState playback;
+
+    std::mutex prefetchMutex;
+    PrefetchConfig prefetchConfig;
+    std::chrono::steady_clock::time_point lastQueueFetch;
+    std::chrono::steady_clock::time_point queueWindowStart;
+    int queueFetchesInWindow = 0;
+    std::atomic<bool> queueFetchInFlight{false};
+    std::atomic<bool> queueForbidden{false};
+    TrackParser queueParser;
+    std::vector<SpotifyTrack> upcoming;
+
+    std::mutex deliveryMutex;
+    SpotifyTrack lastDelivered;
+    bool hasDelivered = false;
+
+    std::string baseUrl;
+    std::shared_ptr<ConnectionCounters> counters;
+    // Swapped whole when the timeout changes; requests in flight keep the old one
+    std::shared_ptr<http_client> client;
+    RateLimiter limiter;
+    WorkerPool workers;
+
+    explicit Impl(const std::string& baseUrl)
+        : baseUrl(baseUrl),
+          counters(std::make_shared<ConnectionCounters>()),
+          client(std::make_shared<http_client>(baseUrl, makeClientConfig(counters, std::chrono::seconds(10)))),
+          limiter(20, 0.5, 5),
+          workers(2, 8) {}
+
+    std::shared_ptr<http_client> currentClient() const {
+        return std::atomic_load(&client);
+    }
+
+    bool authenticated() const {
+        return !credentials.current().token.empty();
+    }
+
+    // Requests are built by a factory so a 401 can be replayed with a freshly
+    // built copy; a client-side request's body cannot be read back out of it.
+    using RequestFactory = std::function<http_request()>;
+
+    http_response send(const RequestFactory& build, TaskKind kind) {
+        const Credential credential = credentials.current();
+        if (credential.generation == 0) {
+            throw std::runtime_error("Not authenticated");
+        }
+
+        if (!limiter.tryAcquire(kind)) {
+            throw std::runtime_error("Rate limited, request not sent");
+        }
+
+        http_request request = build();
+        const auto endpoint = request.request_uri().path();
+
+        request.headers().add("Authorization", credential.authorization);
+        auto response = perform(request, endpoint);
+
+        if (response.status_code() == status_codes::Unauthorized) {
+            const Credential fresh = renewToken(credential.generation);
+
+            // The replay is a request of its own and pays for it like one
+            if (fresh.generation != 0 && limiter.tryAcquire(kind)) {
+                Metrics::getInstance().recordRetry(endpoint);
+
+                http_request retry = build();
+                retry.headers().add("Authorization", fresh.authorization);
+                response = perform(retry, endpoint);
+            }
+        }
+
+        if (response.status_code() == status_codes::TooManyRequests) {
+            limiter.onRetryAfter(parseRetryAfter(response));
+        }
+
+        return response;
+    }
+
+    http_response perform(const http_request& request, const std::string& endpoint) {
+        ++counters->requests;
+
+        const auto started = std::chrono::steady_clock::now();
+        try {
+            auto response = currentClient()->request(request).get();
+            Metrics::getInstance().recordRequest(endpoint, elapsedSince(started), response.status_code());
+            return response;
+        } catch (const std::exception&) {
+            Metrics::getInstance().recordRequest(endpoint, elapsedSince(started), 0);
+            throw;
+        }
+    }
+
+    Credential renewToken(uint64_t rejected) {
+        std::lock_guard<std::mutex> lock(refreshMutex);
+        if (!tokenRefresher_) return {};
+
+        // Only the first worker to see the 401 refreshes; the rest reuse its token
+        const Credential latest = credentials.current();
+        if (latest.generation != rejected) return latest;
+
+        Log::stream(LogLevel::INFO) << "Access token rejected, refreshing" << std::endl;
+        const std::string fresh = tokenRefresher_(latest.token);
+        if (fresh.empty()) return {};
+        return credentials.publish(fresh);
+    }
+
+    void publish() {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+
+        const SpotifyTrack track = playback.current();
+        const TrackChanges changes = hasDelivered ? diffTracks(lastDelivered, track) : TrackChanges::all();
+        if (!changes.any()) return;
+
+        lastDelivered = track;
+        hasDelivered = true;
+
+        if (Log::enabled(LogLevel::DEBUG)) {
+            Log::stream(LogLevel::DEBUG) << "Retrieved track: " << track.name << " - " << track.artist << std::endl;
+        }
+
+        if (trackCallback_) {
+            trackCallback_(track, changes);
+        }
+
+        if (changes.track) {
+            maybeFetchQueue();
+        }
+    }
+
+    void maybeFetchQueue() {
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            const auto now = std::chrono::steady_clock::now();
 
-    Impl() = default;
+            if (prefetchConfig.lookahead <= 0 || queueForbidden) return;
+
+            if (now - queueWindowStart >= std::chrono::hours(1)) {
+                queueWindowStart = now;
+                queueFetchesInWindow = 0;
+            }
+            if (queueFetchesInWindow >= prefetchConfig.maxRequestsPerHour) return;
+            if (lastQueueFetch.time_since_epoch().count() != 0 &&
+                now - lastQueueFetch < prefetchConfig.minQueueInterval) return;
+            if (queueFetchInFlight.exchange(true)) return;
+
+            lastQueueFetch = now;
+            ++queueFetchesInWindow;
+        }
+
+        if (workers.submit([this]() { fetchQueue(); }, TaskKind::PREFETCH) != SubmitResult::QUEUED) {
+            queueFetchInFlight = false;
+        }
+    }
+
+    void fetchQueue() {
+        try {
+            const std::string endpoint = "/me/player/queue";
+            const auto response = send([&endpoint]() {
+                http_request request(methods::GET);
+                request.set_request_uri(endpoint);
+                request.headers().add("Accept", "application/json");
+                return request;
+            }, TaskKind::PREFETCH);
+
+            if (response.status_code() == status_codes::OK) {
+                const auto body = response.extract_utf8string(true).get();
+                Metrics::getInstance().recordBytes(endpoint, body.size());
+
+                size_t lookahead;
+                {
+                    std::lock_guard<std::mutex> lock(prefetchMutex);
+                    lookahead = static_cast<size_t>(std::max(prefetchConfig.lookahead, 0));
+                }
+
+                if (queueParser.parseQueue(body, upcoming, lookahead, artworkSize)) {
+                    playback.setUpcoming(upcoming);
+                    if (queueCallback_) {
+                        queueCallback_(upcoming);
+                    }
+                } else {
+                    Log::stream(LogLevel::ERROR) << "Malformed queue response" << std::endl;
+                }
+            } else if (response.status_code() == status_codes::Forbidden) {
+                // Tokens granted before the queue scope was requested can never read it
+                queueForbidden = true;
+                Log::stream(LogLevel::WARN) << "Queue access denied, prefetch disabled. Delete tokens.json and sign in again "
+                             "to grant user-read-playback-state" << std::endl;
+            } else {
+                Log::stream(LogLevel::ERROR) << "Queue request failed: " << response.status_code() << std::endl;
+            }
+        } catch (const std::exception& e) {
+            Log::stream(LogLevel::ERROR) << "Error fetching queue: " << e.what() << std::endl;
+        }
+
+        queueFetchInFlight = false;
+    }
+
+    void reschedule(const SpotifyTrack& track) {
+        {
+            std::lock_guard<std::mutex> lock(scheduleMutex);
+            if (!polling) return;
+
+            const auto now = std::chrono::steady_clock::now();
+            if (track.isPlaying || playback.hasPending()) {
+                notPlayingSince = {};
+            } else if (notPlayingSince.time_since_epoch().count() == 0) {
+                notPlayingSince = now;
+            } else if (now - notPlayingSince >= pollingConfig.deepIdleAfter && !suspended) {
+                Log::stream(LogLevel::INFO) << "Playback idle, suspending polling" << std::endl;
+                suspended = true;
+            }
+
+            std::chrono::milliseconds delay;
+            if (playback.hasPending()) {
+                delay = pollingConfig.minInterval;
+            } else if (!track.isPlaying) {
+                delay = track.durationMs > 0 ? pollingConfig.pausedInterval : pollingConfig.idleInterval;
+            } else if (track.durationMs > 0) {
+                const auto remaining = std::chrono::milliseconds(std::max(track.durationMs - track.progressMs, 0));
+                delay = std::clamp(remaining + pollingConfig.boundaryDelay,
+                                   pollingConfig.minInterval, pollingConfig.maxInterval);
+            } else {
+                delay = pollingConfig.maxInterval;
+            }
+
+            nextPollAt = now + delay;
+        }
+        scheduleCv.notify_all();
+    }
+
+    void requestPoll() {
+        {
+            std::lock_guard<std::mutex> lock(scheduleMutex);
+            nextPollAt = std::chrono::steady_clock::now();
+            pollFreshAfter = nextPollAt;
+            notPlayingSince = {};
+            suspended = false;
+        }
+        scheduleCv.notify_all();
+    }
+
+    bool joinFetch(TrackCallback success, ErrorCallback error, std::chrono::steady_clock::time_point notBefore) {
+        std::lock_guard<std::mutex> lock(fetchMutex);
+        FetchWaiter waiter{std::move(success), std::move(error)};
+
+        if (!fetchInFlight) {
+            fetchInFlight = true;
+            fetchSentAt = std::chrono::steady_clock::time_point::max();
+            fetchWaiters.push_back(std::move(waiter));
+            return true;
+        }
+
+        if (fetchSentAt >= notBefore) {
+            ++coalescedFetches;
+            fetchWaiters.push_back(std::move(waiter));
+            return false;
+        }
+
+        // The running request predates this caller, so it waits for the next one
+        if (!followUpWaiters.empty()) ++coalescedFetches;
+        followUpWaiters.push_back(std::move(waiter));
+        return false;
+    }
+
+    void markFetchSent() {
+        std::lock_guard<std::mutex> lock(fetchMutex);
+        fetchSentAt = std::chrono::steady_clock::now();
+    }
+
+    std::vector<FetchWaiter> takeWaiters() {
+        std::lock_guard<std::mutex> lock(fetchMutex);
+        auto waiters = std::exchange(fetchWaiters, {});
+
+        if (followUpWaiters.empty()) {
+            fetchInFlight = false;
+        } else {
+            fetchWaiters = std::exchange(followUpWaiters, {});
+            fetchSentAt = std::chrono::steady_clock::time_point::max();
+            followUpQueued = true;
+        }
+        return waiters;
+    }
+
+    bool takeFollowUp() {
+        std::lock_guard<std::mutex> lock(fetchMutex);
+        return std::exchange(followUpQueued, false);
+    }
+
+    void completeFetch(const SpotifyTrack& track) {
+        playback.reconcile(track);
+        reschedule(track);
+
+        const SpotifyTrack current = playback.current();
+        for (const auto& waiter : takeWaiters()) {
+            if (waiter.success) waiter.success(current);
+        }
+
+        publish();
+    }
+
+    void failFetch(const std::string& message) {
+        bool reportGlobally = false;
+
+        for (const auto& waiter : takeWaiters()) {
+            if (waiter.error) {
+                waiter.error(message);
+            } else {
+                reportGlobally = true;
+            }
+        }
+
+        if (reportGlobally && errorCallback_) {
+            errorCallback_(message);
+        }
+    }
+
+    void fail(const ErrorCallback& error, const std::string& message) const {
+        if (error) {
+            error(message);
+        } else if (errorCallback_) {
+            errorCallback_(message);
+        }
+    }
+
+    void warmUp() {
+        ++counters->requests;
+        currentClient()->request(methods::HEAD, "/").then([](pplx::task<http_response> task) {
+            try {
+                task.get();
+                Log::stream(LogLevel::INFO) << "API connection warmed up" << std::endl;
+            } catch (const std::exception& e) {
+                Log::stream(LogLevel::WARN) << "API warm-up failed: " << e.what() << std::endl;
+            }
+        });
+    }
 };
 
-SpotifyAPI::SpotifyAPI() : pImpl_(std::make_unique<Impl>()) {}
+SpotifyAPI::SpotifyAPI(const std::string &baseUrl) : pImpl_(std::make_unique<Impl>(baseUrl)) {
+    pImpl_->warmUp();
+}
 
 SpotifyAPI::~SpotifyAPI() {
     stopPolling();
+    pImpl_->workers.shutdown();
 }
 
 void SpotifyAPI::setAccessToken(const std::string& token) const {
-    pImpl_->accessToken = token;
-    std::cout << "Access token set: " << token.substr(0, 10) << "..." << std::endl;
+    pImpl_->credentials.publish(token);
+    Log::stream(LogLevel::INFO) << "Access token set: " << token.substr(0, 10) << "..." << std::endl;
 }
 
-void SpotifyAPI::setTrackCallback(const TrackCallback &callback) const {
+void SpotifyAPI::setTrackCallback(const TrackChangeCallback &callback) const {
     pImpl_->trackCallback_ = callback;
 }
 
+void SpotifyAPI::setQueueCallback(const QueueCallback &callback) const {
+    pImpl_->queueCallback_ = callback;
+}
+
+void SpotifyAPI::setPrefetchConfig(const PrefetchConfig &config) const {
+    std::lock_guard<std::mutex> lock(pImpl_->prefetchMutex);
+    pImpl_->prefetchConfig = config;
+}
+
+void SpotifyAPI::setTokenRefresher(const TokenRefresher &refresher) const {
+    std::lock_guard<std::mutex> lock(pImpl_->refreshMutex);
+    pImpl_->tokenRefresher_ = refresher;
+}
+
+void SpotifyAPI::setPollingConfig(const PollingConfig &config) const {
+    {
+        std::lock_guard<std::mutex> lock(pImpl_->scheduleMutex);
+        pImpl_->pollingConfig = config;
+        pImpl_->nextPollAt = std::min(pImpl_->nextPollAt, std::chrono::steady_clock::now() + config.maxInterval);
+    }
+    pImpl_->scheduleCv.notify_all();
+}
+
+void SpotifyAPI::setWorkerLimits(size_t threadCount, size_t queueCapacity) const {
+    pImpl_->workers.resize(threadCount, queueCapacity);
+}
+
+void SpotifyAPI::setRequestTimeout(std::chrono::seconds timeout) const {
+    auto client = std::make_shared<http_client>(pImpl_->baseUrl, makeClientConfig(pImpl_->counters, timeout));
+    std::atomic_store(&pImpl_->client, std::move(client));
+}
+
+void SpotifyAPI::setArtworkSize(int pixels) const {
+    pImpl_->artworkSize = pixels;
+}
+
 void SpotifyAPI::setErrorCallback(const ErrorCallback &callback) const {
     pImpl_->errorCallback_ = callback;
 }
 
 void SpotifyAPI::getCurrentTrack(TrackCallback success, ErrorCallback error) const {
-    if (pImpl_->accessToken.empty()) {
-        if (pImpl_->errorCallback_) {
-            pImpl_->errorCallback_("Not authenticated");
-        }
+    fetchCurrent(std::move(success), std::move(error), std::chrono::steady_clock::time_point::min());
+}
+
+void SpotifyAPI::fetchCurrent(TrackCallback success, ErrorCallback error,
+                              std::chrono::steady_clock::time_point notBefore) const {
+    if (!pImpl_->authenticated()) {
+        pImpl_->fail(error, "Not authenticated");
         return;
     }
 
-    std::thread([this]() {
+    if (pImpl_->joinFetch(std::move(success), std::move(error), notBefore)) {
+        startFetch();
+    }
+}
+
+void SpotifyAPI::startFetch() const {
+    const SubmitResult queued = pImpl_->workers.submit([this]() {
         try {
-            http_client client("https://api.spotify.com/v1");
-            http_request request(methods::GET);
+            const std::string endpoint = "/me/player/currently-playing";
 
-            request.set_request_uri("/me/player/currently-playing");
-            request.headers().add("Authorization", "Bearer " + pImpl_->accessToken);
-            request.headers().add("Accept", "application/json");
+            pImpl_->markFetchSent();
+            const auto response = pImpl_->send([&endpoint]() {
+                http_request request(methods::GET);
+                request.set_request_uri(endpoint);
+                request.headers().add("Accept", "application/json");
+                return request;
+            }, TaskKind::POLL);
 
-            if (const auto response = client.request(request).get(); response.status_code() == status_codes::OK) {
-                auto json = response.extract_json().get();
+            if (response.status_code() == status_codes::OK) {
+                const auto receivedAt = std::chrono::steady_clock::now();
+                const auto body = response.extract_utf8string(true).get();
+                Metrics::getInstance().recordBytes(endpoint, body.size());
 
                 SpotifyTrack track;
-                track.isPlaying = json["is_playing"].as_bool();
-
-                auto item = json["item"];
-                track.name = item["name"].as_string();
-
-                if (auto artists = item["artists"]; artists.size() > 0) {
-                    track.artist = artists[0]["name"].as_string();
-
-                    for (size_t i = 1; i < artists.size(); ++i) {
-                        track.artist += ", " + artists[i]["name"].as_string();
-                    }
-                }
-
-                auto album = item["album"];
-                if (auto images = album["images"]; images.size() > 0) {
-                    track.imageUrl = images[0]["url"].as_string();
+                track.fetchedAt = receivedAt;
+                if (!pImpl_->parser.parseCurrentlyPlaying(body, track, pImpl_->artworkSize)) {
+                    pImpl_->failFetch("Malformed currently-playing response");
+                    return;
                 }
 
-                std::cout << "Retrieved track: " << track.name << " - " << track.artist << std::endl;
-
-                if (pImpl_->trackCallback_) {
-                    pImpl_->trackCallback_(track);
-                }
+                pImpl_->completeFetch(track);
             } else if (response.status_code() == status_codes::NoContent) {
-                if (pImpl_->trackCallback_) {
-                    pImpl_->trackCallback_(SpotifyTrack("Not Playing", "", "", false));
-                }
+                SpotifyTrack track("Not Playing", "", "", false);
+                track.fetchedAt = std::chrono::steady_clock::now();
+                pImpl_->completeFetch(track);
             } else if (response.status_code() == status_codes::Unauthorized) {
-                std::cerr << "Authentication expired" << std::endl;
-                if (pImpl_->errorCallback_) {
-                    pImpl_->errorCallback_("Authentication expired");
-                }
+                Log::stream(LogLevel::ERROR) << "Authentication expired" << std::endl;
+                pImpl_->failFetch("Authentication expired");
             } else if (response.status_code() == status_codes::Forbidden) {
-                std::cerr << "Insufficient permissions" << std::endl;
-                if (pImpl_->errorCallback_) {
-                    pImpl_->errorCallback_("Insufficient permissions");
-                }
+                Log::stream(LogLevel::ERROR) << "Insufficient permissions" << std::endl;
+                pImpl_->failFetch("Insufficient permissions");
             } else if (response.status_code() == status_codes::TooManyRequests) {
-                std::cerr << "Rate limit exceeded" << std::endl;
-                if (pImpl_->errorCallback_) {
-                    pImpl_->errorCallback_("Rate limit exceeded");
-                }
+                const auto retryAfter = pImpl_->limiter.blockedFor();
+                pImpl_->failFetch("Rate limit exceeded, retrying in " +
+                              std::to_string(std::chrono::duration_cast<std::chrono::seconds>(retryAfter).count()) + "s");
             } else {
-                std::cerr << "HTTP error: " << response.status_code() << std::endl;
-                if (pImpl_->errorCallback_) {
-                    pImpl_->errorCallback_("HTTP " + std::to_string(response.status_code()));
-                }
+                Log::stream(LogLevel::ERROR) << "HTTP error: " << response.status_code() << std::endl;
+                pImpl_->failFetch("HTTP " + std::to_string(response.status_code()));
             }
         } catch (const std::exception& e) {
-            std::cerr << "Error in getCurrentTrack: " << e.what() << std::endl;
-            if (pImpl_->errorCallback_) {
-                pImpl_->errorCallback_(e.what());
-            }
+            Log::stream(LogLevel::ERROR) << "Error in getCurrentTrack: " << e.what() << std::endl;
+            pImpl_->failFetch(e.what());
         }
-    }).detach();
+
+        if (pImpl_->takeFollowUp()) startFetch();
+    }, TaskKind::POLL);
+
+    if (queued != SubmitResult::QUEUED) {
+        pImpl_->failFetch(queued == SubmitResult::DUPLICATE ? "A poll is already queued" : "Request queue is full");
+        if (pImpl_->takeFollowUp()) startFetch();
+    }
 }
 
 void SpotifyAPI::controlPlayback(PlayBackAction action, std::function<void(bool)> callback) const {
-    if (pImpl_->accessToken.empty()) {
-        std::cerr << "Cannot control playback: not authenticated" << std::endl;
+    if (!pImpl_->authenticated()) {
+        Log::stream(LogLevel::ERROR) << "Cannot control playback: not authenticated" << std::endl;
         if (callback) callback(false);
         return;
     }
 
-    std::thread([this, action, callback]() {
+    const PlayBackAction resolved = pImpl_->playback.resolve(action);
+    const uint64_t commandId = pImpl_->playback.apply(resolved);
+    pImpl_->publish();
+
+    const bool queued = pImpl_->workers.submit([this, resolved, commandId, callback]() {
+        bool success = false;
+
         try {
-            http_client client("https://api.spotify.com/v1");
             std::string endpoint;
             method method;
 
-            switch (action) {
+            switch (resolved) {
                 case PlayBackAction::PLAY:
                     method = methods::PUT;
                     endpoint = "/me/player/play";
-                    std::cout << "Sending play command" << std::endl;
+                    Log::stream(LogLevel::INFO) << "Sending play command" << std::endl;
                     break;
 
                 case PlayBackAction::PAUSE:
                     method = methods::PUT;
                     endpoint = "/me/player/pause";
-                    std::cout << "Sending pause command" << std::endl;
+                    Log::stream(LogLevel::INFO) << "Sending pause command" << std::endl;
                     break;
 
                 case PlayBackAction::NEXT:
                     method = methods::POST;
                     endpoint = "/me/player/next";
-                    std::cout << "Sending next track command" << std::endl;
+                    Log::stream(LogLevel::INFO) << "Sending next track command" << std::endl;
                     break;
 
                 case PlayBackAction::PREVIOUS:
                     method = methods::POST;
                     endpoint = "/me/player/previous";
-                    std::cout << "Sending previous track command" << std::endl;
+                    Log::stream(LogLevel::INFO) << "Sending previous track command" << std::endl;
                     break;
 
                 default:
-                    std::cerr << "Unknown playback action: " << static_cast<int>(action) << std::endl;
-                    if (callback) callback(false);
-                    return;
+                    throw std::invalid_argument("Unknown playback action: " + std::to_string(static_cast<int>(resolved)));
             }
 
-            const auto request = std::make_unique<http_request>(method);
-            request->set_request_uri(endpoint);
-            request->headers().add("Authorization", "Bearer " + pImpl_->accessToken);
-            request->headers().add("Content-Type", "application/json");
-
-            if (method == methods::PUT && endpoint == "/me/player/play") {
-                const json::value body;
-                request->set_body(body);
-            }
+            const auto response = pImpl_->send([&method, &endpoint]() {
+                http_request request(method);
+                request.set_request_uri(endpoint);
+                request.headers().add("Content-Type", "application/json");
 
-            const auto response = client.request(*request).get();
+                if (method == methods::PUT && endpoint == "/me/player/play") {
+                    const json::value body;
+                    request.set_body(body);
+                }
+                return request;
+            }, TaskKind::COMMAND);
 
-            const bool success = (response.status_code() == status_codes::OK ||
-                          response.status_code() == status_codes::NoContent ||
-                          response.status_code() == status_codes::Accepted);
+            success = (response.status_code() == status_codes::OK ||
+                       response.status_code() == status_codes::NoContent ||
+                       response.status_code() == status_codes::Accepted);
 
             if (success) {
-                std::cout << "Playback control successful" << std::endl;
-
-                if (action != PlayBackAction::TOGGLE) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                    getCurrentTrack(nullptr, nullptr);
+                if (Log::enabled(LogLevel::DEBUG)) {
+                    Log::stream(LogLevel::DEBUG) << "Playback control successful" << std::endl;
                 }
             } else {
-                std::cerr << "Playback control failed with status: " << response.status_code() << std::endl;
+                Log::stream(LogLevel::ERROR) << "Playback control failed with status: " << response.status_code() << std::endl;
 
                 try {
                     const auto errorBody = response.extract_string().get();
-                    std::cerr << "Error response: " << errorBody << std::endl;
+                    Log::stream(LogLevel::ERROR) << "Error response: " << errorBody << std::endl;
                 } catch (...) {
                     // Ignore errors in error extraction
                 }
             }
+        } catch (const std::exception& e) {
+            Log::stream(LogLevel::ERROR) << "Exception in controlPlayback: " << e.what() << std::endl;
+        }
 
-            if (callback) {
-                callback(success);
-            }
+        finishCommand(commandId, success);
 
-        } catch (const std::exception& e) {
-            std::cerr << "Exception in controlPlayback: " << e.what() << std::endl;
-            if (callback) {
-                callback(false);
-            }
+        if (callback) {
+            callback(success);
         }
-    }).detach();
+    }, TaskKind::COMMAND) == SubmitResult::QUEUED;
+
+    if (!queued) {
+        Log::stream(LogLevel::WARN) << "Cannot control playback: request queue is full" << std::endl;
+        finishCommand(commandId, false);
+        if (callback) callback(false);
+    }
+}
+
+void SpotifyAPI::finishCommand(uint64_t commandId, bool success) const {
+    if (success) {
+        pImpl_->playback.acknowledge(commandId);
+        refreshAfterCommand();
+    } else {
+        // Roll the optimistic state back to what the server last reported
+        pImpl_->playback.reject(commandId);
+        pImpl_->publish();
+    }
 }
 
 
-void SpotifyAPI::startPolling(std::chrono::seconds interval) const {
+void SpotifyAPI::startPolling(const PollingConfig &config) const {
     if (pImpl_->polling) {
-        std::cout << "Polling already started" << std::endl;
+        Log::stream(LogLevel::INFO) << "Polling already started" << std::endl;
         return;
     }
 
-    pImpl_->polling = true;
-    pImpl_->pollingThread = std::thread([this, interval]() {
-        std::cout << "Starting track polling every " << interval.count() << " seconds" << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(pImpl_->scheduleMutex);
+        pImpl_->pollingConfig = config;
+        pImpl_->nextPollAt = std::chrono::steady_clock::now();
+        pImpl_->polling = true;
+    }
 
-        while (pImpl_->polling) {
-            try {
-                getCurrentTrack(nullptr, nullptr);
+    pImpl_->pollingThread = std::thread([this]() {
+        Log::stream(LogLevel::INFO) << "Starting adaptive track polling" << std::endl;
 
-                auto sleepTime = std::chrono::milliseconds(100);
-                auto totalSleep = std::chrono::milliseconds(0);
-                while (pImpl_->polling && totalSleep < interval) {
-                    std::this_thread::sleep_for(sleepTime);
-                    totalSleep += sleepTime;
+        while (pImpl_->polling) {
+            std::chrono::steady_clock::time_point freshAfter;
+            {
+                std::unique_lock<std::mutex> lock(pImpl_->scheduleMutex);
+                while (pImpl_->polling &&
+                       (pImpl_->suspended || std::chrono::steady_clock::now() < pImpl_->nextPollAt)) {
+                    if (pImpl_->suspended) {
+                        pImpl_->scheduleCv.wait(lock);
+                    } else {
+                        pImpl_->scheduleCv.wait_until(lock, pImpl_->nextPollAt);
+                    }
                 }
-            } catch (const std::exception& e) {
-                std::cerr << "Error in polling thread: " << e.what() << std::endl;
-                if (pImpl_->polling) {
-                    std::this_thread::sleep_for(interval);
+                if (!pImpl_->polling) break;
+
+                if (const auto blocked = pImpl_->limiter.blockedFor(); blocked.count() > 0) {
+                    pImpl_->nextPollAt = std::chrono::steady_clock::now() + blocked;
+                    continue;
                 }
+
+                // Fallback if this poll is dropped or fails; a successful poll reschedules
+                pImpl_->nextPollAt = std::chrono::steady_clock::now() + pImpl_->pollingConfig.maxInterval;
+                freshAfter = pImpl_->pollFreshAfter;
             }
+
+            fetchCurrent(nullptr, nullptr, freshAfter);
         }
 
-        std::cout << "Polling thread stopped" << std::endl;
+        Log::stream(LogLevel::INFO) << "Polling thread stopped" << std::endl;
     });
 }
 
 void SpotifyAPI::stopPolling() const {
     if (pImpl_->polling) {
-        std::cout << "Stopping track polling" << std::endl;
-        pImpl_->polling = false;
+        Log::stream(LogLevel::INFO) << "Stopping track polling" << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(pImpl_->scheduleMutex);
+            pImpl_->polling = false;
+        }
+        pImpl_->scheduleCv.notify_all();
         if (pImpl_->pollingThread.joinable()) {
             pImpl_->pollingThread.join();
         }
     }
 }
 
+void SpotifyAPI::suspendPolling() const {
+    std::lock_guard<std::mutex> lock(pImpl_->scheduleMutex);
+    if (pImpl_->polling && !pImpl_->suspended) {
+        Log::stream(LogLevel::INFO) << "Suspending track polling" << std::endl;
+        pImpl_->suspended = true;
+    }
+}
+
+void SpotifyAPI::resumePolling() const {
+    {
+        std::lock_guard<std::mutex> lock(pImpl_->scheduleMutex);
+        if (!pImpl_->suspended) return;
+
+        Log::stream(LogLevel::INFO) << "Resuming track polling" << std::endl;
+        pImpl_->suspended = false;
+        pImpl_->notPlayingSince = {};
+        pImpl_->nextPollAt = std::chrono::steady_clock::now();
+    }
+    pImpl_->scheduleCv.notify_all();
+}
+
+void SpotifyAPI::refreshAfterCommand() const {
+    if (pImpl_->polling) {
+        pImpl_->requestPoll();
+    } else {
+        fetchCurrent(nullptr, nullptr, std::chrono::steady_clock::now());
+    }
+}
+
 void SpotifyAPI::getPlaybackState(std::function<void(const SpotifyTrack&)> callback) const {
-    getCurrentTrack(nullptr, nullptr);
+    getCurrentTrack(std::move(callback), nullptr);
 }
 
 void SpotifyAPI::setVolume(int volumePercent, std::function<void(bool)> callback) const {
-    if (pImpl_->accessToken.empty()) {
+    if (!pImpl_->authenticated()) {
         if (callback) callback(false);
         return;
     }
 
-    std::thread([this, volumePercent, callback]() {
+    const bool queued = pImpl_->workers.submit([this, volumePercent, callback]() {
         try {
-            http_client client("https://api.spotify.com/v1");
-            http_request request(methods::PUT);
-
             std::stringstream uri;
             uri << "/me/player/volume?volume_percent=" << volumePercent;
-            request.set_request_uri(uri.str());
-            request.headers().add("Authorization", "Bearer " + pImpl_->accessToken);
 
-            const auto response = client.request(request).get();
+            const auto response = pImpl_->send([target = uri.str()]() {
+                http_request request(methods::PUT);
+                request.set_request_uri(target);
+                return request;
+            }, TaskKind::COMMAND);
 
             const bool success = (response.status_code() == status_codes::OK ||
                           response.status_code() == status_codes::NoContent);
@@ -286,37 +813,41 @@ void SpotifyAPI::setVolume(int volumePercent, std::function<void(bool)> callback
             }
 
             if (success) {
-                std::cout << "Volume set to " << volumePercent << "%" << std::endl;
+                Log::stream(LogLevel::INFO) << "Volume set to " << volumePercent << "%" << std::endl;
             } else {
-                std::cerr << "Volume control failed: " << response.status_code() << std::endl;
+                Log::stream(LogLevel::ERROR) << "Volume control failed: " << response.status_code() << std::endl;
             }
 
         } catch (const std::exception& e) {
-            std::cerr << "Volume control error: " << e.what() << std::endl;
+            Log::stream(LogLevel::ERROR) << "Volume control error: " << e.what() << std::endl;
             if (callback) {
                 callback(false);
             }
         }
-    }).detach();
+    }, TaskKind::COMMAND) == SubmitResult::QUEUED;
+
+    if (!queued) {
+        Log::stream(LogLevel::WARN) << "Cannot set volume: request queue is full" << std::endl;
+        if (callback) callback(false);
+    }
 }
 
 void SpotifyAPI::seekToPosition(int positionMs, const std::function<void(bool)>& callback) const {
-    if (pImpl_->accessToken.empty()) {
+    if (!pImpl_->authenticated()) {
         if (callback) callback(false);
         return;
     }
 
-    std::thread([this, positionMs, callback]() {
+    const bool queued = pImpl_->workers.submit([this, positionMs, callback]() {
         try {
-            http_client client("https://api.spotify.com/v1");
-            http_request request(methods::PUT);
-
             std::stringstream uri;
             uri << "/me/player/seek?position_ms=" << positionMs;
-            request.set_request_uri(uri.str());
-            request.headers().add("Authorization", "Bearer " + pImpl_->accessToken);
 
-            const auto response = client.request(request).get();
+            const auto response = pImpl_->send([target = uri.str()]() {
+                http_request request(methods::PUT);
+                request.set_request_uri(target);
+                return request;
+            }, TaskKind::COMMAND);
 
             const bool success = (response.status_code() == status_codes::OK ||
                           response.status_code() == status_codes::NoContent);
@@ -326,20 +857,45 @@ void SpotifyAPI::seekToPosition(int positionMs, const std::function<void(bool)>&
             }
 
             if (success) {
-                std::cout << "Seeked to position: " << positionMs << "ms" << std::endl;
+                Log::stream(LogLevel::INFO) << "Seeked to position: " << positionMs << "ms" << std::endl;
+                refreshAfterCommand();
             } else {
-                std::cerr << "Seek failed: " << response.status_code() << std::endl;
+                Log::stream(LogLevel::ERROR) << "Seek failed: " << response.status_code() << std::endl;
             }
 
         } catch (const std::exception& e) {
-            std::cerr << "Seek error: " << e.what() << std::endl;
+            Log::stream(LogLevel::ERROR) << "Seek error: " << e.what() << std::endl;
             if (callback) {
                 callback(false);
             }
         }
-    }).detach();
+    }, TaskKind::COMMAND) == SubmitResult::QUEUED;
+
+    if (!queued) {
+        Log::stream(LogLevel::WARN) << "Cannot seek: request queue is full" << std::endl;
+        if (callback) callback(false);
+    }
 }
 
 bool SpotifyAPI::isPolling() const {
     return pImpl_->polling;
+}
+
+uint64_t SpotifyAPI::getCoalescedRequestCount() const {
+    return pImpl_->coalescedFetches;
+}
+
+RateLimitStats SpotifyAPI::getRateLimitStats() const {
+    return pImpl_->limiter.getStats();
+}
+
+WorkerPoolStats SpotifyAPI::getExecutorStats() const {
+    return pImpl_->workers.getStats();
+}
+
+ConnectionStats SpotifyAPI::getConnectionStats() const {
+    ConnectionStats stats;
+    stats.requests = pImpl_->counters->requests;
+    stats.handshakes = pImpl_->counters->handshakes;
+    return stats;
 }
\ No newline at end of file
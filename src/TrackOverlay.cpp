@@ -4,6 +4,9 @@
 
 #include "TrackOverlay.h"
 #include "SpotifyAPI.h"
+#include "ConfigManager.h"
+#include "Metrics.h"
+#include "Log.h"
 #include <QTimer>
 #include <QNetworkRequest>
 #include <QNetworkReply>
@@ -13,10 +16,37 @@
 #include <QPainter>
 #include <QGraphicsDropShadowEffect>
 #include <QPainterPath>
+#include <QtMath>
+#include <QPaintEvent>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
 
-TrackOverlay::TrackOverlay(QWidget *parent) :
+namespace {
+    const auto PrefetchAttribute = static_cast<QNetworkRequest::Attribute>(QNetworkRequest::User + 1);
+
+    const QRect CompactArtRect(12, 12, 64, 64);
+    const QRect CompactTextRect(88, 12, 126, 64);
+
+    struct CompactButton {
+        QRect rect;
+        PlayBackAction action;
+    };
+
+    const CompactButton CompactButtons[] = {
+        {QRect(220, 29, 30, 30), PlayBackAction::PREVIOUS},
+        {QRect(254, 29, 30, 30), PlayBackAction::TOGGLE},
+        {QRect(288, 29, 30, 30), PlayBackAction::NEXT},
+    };
+
+    const QRect CompactControlsRect(220, 29, 98, 30);
+
+    const QRect ProgressRect(12, 81, 306, 3);
+}
+
+TrackOverlay::TrackOverlay(QWidget *parent, OverlayMode mode) :
     QWidget(parent),
+    mode_(mode),
     albumArtLabel(nullptr),
     trackLabel(nullptr),
     artistLabel(nullptr),
@@ -28,7 +58,7 @@ TrackOverlay::TrackOverlay(QWidget *parent) :
     isDragging(false),
     dragStartPosition()
 {
-    std::cout << "TrackOverlay constructor started" << std::endl;
+    Log::stream(LogLevel::INFO) << "TrackOverlay constructor started" << std::endl;
 
     setWindowFlags(Qt::WindowStaysOnTopHint |
                    Qt::Tool |
@@ -45,6 +75,45 @@ TrackOverlay::TrackOverlay(QWidget *parent) :
     connect(networkManager, &QNetworkAccessManager::finished,
             this, &TrackOverlay::onImageDownloaded);
 
+    progressTimer_ = new QTimer(this);
+    connect(progressTimer_, &QTimer::timeout, this, &TrackOverlay::advanceProgress);
+
+    artPipeline_ = new AlbumArtPipeline(&artCache_, this);
+    connect(artPipeline_, &AlbumArtPipeline::finished,
+            this, &TrackOverlay::onAlbumArtRendered);
+    connect(artPipeline_, &AlbumArtPipeline::diskMissed,
+            this, &TrackOverlay::onAlbumArtMissed);
+
+    if (mode_ == OverlayMode::WIDGETS) {
+        buildWidgets();
+    } else {
+        trackFont_ = font();
+        trackFont_.setPixelSize(14);
+        trackFont_.setWeight(QFont::DemiBold);
+
+        artistFont_ = font();
+        artistFont_.setPixelSize(12);
+
+        buttonFont_ = trackFont_;
+        buttonFont_.setPixelSize(16);
+
+        compactArt_ = getDefaultAlbumArt();
+        showText("No track playing", "--");
+    }
+
+    setFixedSize(330, 88);
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    if (QApplication::primaryScreen()) {
+        auto screenGeometry = QApplication::primaryScreen()->availableGeometry();
+        move(screenGeometry.right() - width() - 20, 20);
+    }
+
+    Log::stream(LogLevel::INFO) << "TrackOverlay constructor completed" << std::endl;
+}
+
+void TrackOverlay::buildWidgets() {
     mainLayout = new QHBoxLayout(this);
     mainLayout->setContentsMargins(2, 12, 12, 12);
     mainLayout->setSpacing(12);
@@ -102,52 +171,42 @@ TrackOverlay::TrackOverlay(QWidget *parent) :
     mainLayout->addLayout(btnLayout);
 
     connect(playPause, &QPushButton::clicked, this, [this]() {
-        if (isPlaying) {
-            playPause->setText("⏸");
-            spotify_api_->controlPlayback(PlayBackAction::PAUSE, nullptr);
-        }
-        else {
-            playPause->setText("▶");
-
-            spotify_api_->controlPlayback(PlayBackAction::PLAY, nullptr);
-        }
+        triggerAction(PlayBackAction::TOGGLE);
     });
 
     connect(nextTrack, &QPushButton::clicked, this, [this]() {
-        spotify_api_->controlPlayback(PlayBackAction::NEXT, nullptr);
+        triggerAction(PlayBackAction::NEXT);
     });
 
     connect(backTrack, &QPushButton::clicked, this, [this]() {
-        spotify_api_->controlPlayback(PlayBackAction::PREVIOUS, nullptr);
+        triggerAction(PlayBackAction::PREVIOUS);
     });
 
     setDefaultStyles();
-
-    setFixedSize(330, 88);
-
-    setAutoFillBackground(true);
-
-    if (QApplication::primaryScreen()) {
-        auto screenGeometry = QApplication::primaryScreen()->availableGeometry();
-        move(screenGeometry.right() - width() - 20, 20);
-    }
-
-    std::cout << "TrackOverlay constructor completed" << std::endl;
 }
 
 TrackOverlay::~TrackOverlay() {
-    std::cout << "TrackOverlay destructor called" << std::endl;
+    Log::stream(LogLevel::INFO) << "TrackOverlay destructor called" << std::endl;
     if (spotify_api_) {
         spotify_api_->stopPolling();
     }
+
+    // Its worker still uses artCache_, which goes before QObject deletes children
+    delete artPipeline_;
+    artPipeline_ = nullptr;
 }
 
-void TrackOverlay::updateTrackInfo(const SpotifyTrack &track) {
-    std::cout << "=== updateTrackInfo called ===" << std::endl;
-    std::cout << "Track: '" << track.name << "'" << std::endl;
-    std::cout << "Artist: '" << track.artist << "'" << std::endl;
-    std::cout << "Image URL: '" << track.imageUrl << "'" << std::endl;
-    std::cout << "IsPlaying: " << track.isPlaying << std::endl;
+void TrackOverlay::updateTrackInfo(const SpotifyTrack &track, const TrackChanges &changes) {
+    ScopedSpan span("update_track_info");
+
+    const bool debug = Log::enabled(LogLevel::DEBUG);
+    if (debug) {
+        Log::stream(LogLevel::DEBUG) << "=== updateTrackInfo called ===" << std::endl;
+        Log::stream(LogLevel::DEBUG) << "Track: '" << track.name << "'" << std::endl;
+        Log::stream(LogLevel::DEBUG) << "Artist: '" << track.artist << "'" << std::endl;
+        Log::stream(LogLevel::DEBUG) << "Image URL: '" << track.imageUrl << "'" << std::endl;
+        Log::stream(LogLevel::DEBUG) << "IsPlaying: " << track.isPlaying << std::endl;
+    }
 
     QString trackText = QString::fromStdString(track.name.empty() ? "No track" : track.name);
     QString artistText = QString::fromStdString(track.artist.empty() ? "Unknown artist" : track.artist);
@@ -159,95 +218,98 @@ void TrackOverlay::updateTrackInfo(const SpotifyTrack &track) {
         artistText = artistText.left(37) + "...";
     }
 
-    isPlaying = track.isPlaying;
-
-    playPause->setHidden(false);
-    nextTrack->setHidden(false);
-    backTrack->setHidden(false);
+    if (!display_.controlsVisible) {
+        showControls();
+        display_.controlsVisible = true;
+    }
 
-    trackLabel->setText(trackText);
-    artistLabel->setText(artistText);
+    if (trackText != display_.trackText || artistText != display_.artistText) {
+        showText(trackText, artistText);
+        display_.trackText = trackText;
+        display_.artistText = artistText;
+    }
 
-    if (!track.imageUrl.empty()) {
-        std::cout << "Loading album art from: " << track.imageUrl << std::endl;
+    if (changes.artwork) {
+        if (debug) {
+            Log::stream(LogLevel::DEBUG) << "Loading album art from: '" << track.imageUrl << "'" << std::endl;
+        }
         loadAlbumArt(track.imageUrl);
-    } else {
-        std::cout << "No image URL, using default album art" << std::endl;
-        albumArtLabel->setPixmap(getDefaultAlbumArt());
     }
 
-    if(track.isPlaying) {
-        playPause->setText("⏸");
-
-        setStyleSheet(R"(
-            TrackOverlay {
-                background: #141414;
-                color: white;
-            }
-        )");
-    } else {
-        playPause->setText("▶");
-
-        setStyleSheet(R"(
-            TrackOverlay {
-                background: #141414;
-                color: white;
-            }
-        )");
+    if (!display_.hasPlayState || track.isPlaying != display_.isPlaying) {
+        showPlayState(track.isPlaying);
+        display_.isPlaying = track.isPlaying;
+        display_.hasPlayState = true;
     }
 
-    update();
-    repaint();
+    resyncProgress(track);
 
-    std::cout << "=== updateTrackInfo completed ===" << std::endl;
+    if (debug) {
+        Log::stream(LogLevel::DEBUG) << "=== updateTrackInfo completed ===" << std::endl;
+    }
 }
 
 void TrackOverlay::setAccessToken(const std::string &token) {
-    std::cout << "setAccessToken called, token length: " << token.length() << std::endl;
+    Log::stream(LogLevel::INFO) << "setAccessToken called, token length: " << token.length() << std::endl;
 
     if (token.empty()) {
-        std::cerr << "ERROR: Empty access token!" << std::endl;
+        Log::stream(LogLevel::ERROR) << "ERROR: Empty access token!" << std::endl;
         return;
     }
 
     if (!spotify_api_) {
         try {
-            spotify_api_ = std::make_unique<SpotifyAPI>();
-            std::cout << "SpotifyAPI created successfully" << std::endl;
+            spotify_api_ = std::make_unique<SpotifyAPI>(ConfigManager::getInstance().getApiBaseUrl());
+            spotify_api_->setArtworkSize(qCeil(64 * devicePixelRatioF()));
+            spotify_api_->setPrefetchConfig(prefetchConfig_);
+            spotify_api_->setTokenRefresher(tokenRefresher_);
+            spotify_api_->setWorkerLimits(settings_.workerThreads, settings_.workerQueue);
+            if (settings_.requestTimeout != PerformanceSettings().requestTimeout) {
+                spotify_api_->setRequestTimeout(settings_.requestTimeout);
+            }
+            Log::stream(LogLevel::INFO) << "SpotifyAPI created successfully" << std::endl;
         } catch (const std::exception& e) {
-            std::cerr << "Failed to create SpotifyAPI: " << e.what() << std::endl;
+            Log::stream(LogLevel::ERROR) << "Failed to create SpotifyAPI: " << e.what() << std::endl;
             return;
         }
     }
 
     if (spotify_api_) {
         spotify_api_->setAccessToken(token);
-        std::cout << "Access token set in SpotifyAPI" << std::endl;
+        Log::stream(LogLevel::INFO) << "Access token set in SpotifyAPI" << std::endl;
     }
 }
 
-void TrackOverlay::startPolling(int intervalSeconds) {
-    std::cout << "startPolling called with interval: " << intervalSeconds << " seconds" << std::endl;
+void TrackOverlay::startPolling(const PollingConfig& config) {
+    Log::stream(LogLevel::INFO) << "startPolling called with interval: " << config.minInterval.count()
+              << "-" << config.maxInterval.count() << " ms" << std::endl;
 
     if (spotify_api_) {
-        spotify_api_->setTrackCallback([this](const SpotifyTrack& track) {
-            std::cout << "SpotifyAPI callback received track update" << std::endl;
+        spotify_api_->setTrackCallback([this](const SpotifyTrack& track, const TrackChanges& changes) {
+            const auto queuedAt = std::chrono::steady_clock::now();
 
-            QTimer::singleShot(0, this, [this, track]() {
-                std::cout << "Executing track update in main thread..." << std::endl;
-                this->updateTrackInfo(track);
+            QTimer::singleShot(0, this, [this, track, changes, queuedAt]() {
+                Metrics::getInstance().recordSpan("callback_queue_delay",
+                    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - queuedAt));
+                this->updateTrackInfo(track, changes);
+            });
+        });
+
+        spotify_api_->setQueueCallback([this](const std::vector<SpotifyTrack>& tracks) {
+            QTimer::singleShot(0, this, [this, tracks]() {
+                this->prefetchAlbumArt(tracks);
             });
         });
 
         spotify_api_->setErrorCallback([](const std::string& error) {
-            std::cerr << "Spotify API Error: " << error << std::endl;
+            Log::stream(LogLevel::ERROR) << "Spotify API Error: " << error << std::endl;
         });
 
-        spotify_api_->startPolling(std::chrono::seconds(intervalSeconds));
-        std::cout << "Polling started successfully" << std::endl;
+        spotify_api_->startPolling(config);
+        Log::stream(LogLevel::INFO) << "Polling started successfully" << std::endl;
 
     } else {
-        std::cerr << "ERROR: Cannot start polling - SpotifyAPI not initialized" << std::endl;
+        Log::stream(LogLevel::ERROR) << "ERROR: Cannot start polling - SpotifyAPI not initialized" << std::endl;
 
         SpotifyTrack errorTrack;
         errorTrack.name = "API Not Ready";
@@ -256,51 +318,425 @@ void TrackOverlay::startPolling(int intervalSeconds) {
     }
 }
 
+void TrackOverlay::stopPolling() {
+    if (spotify_api_) {
+        spotify_api_->stopPolling();
+    }
+}
+
+void TrackOverlay::setPrefetchConfig(const PrefetchConfig& config) {
+    prefetchConfig_ = config;
+
+    if (spotify_api_) {
+        spotify_api_->setPrefetchConfig(config);
+    }
+}
+
+void TrackOverlay::applySettings(const PerformanceSettings& settings) {
+    artCache_.setLimits(settings.artMemoryEntries, settings.artDiskBytes);
+    artPipeline_->trimDisk();
+    setPrefetchConfig(settings.prefetch);
+
+    if (spotify_api_) {
+        spotify_api_->setPollingConfig(settings.polling);
+        spotify_api_->setWorkerLimits(settings.workerThreads, settings.workerQueue);
+        if (settings.requestTimeout != settings_.requestTimeout) {
+            spotify_api_->setRequestTimeout(settings.requestTimeout);
+        }
+    }
+
+    settings_ = settings;
+}
+
+void TrackOverlay::setTokenRefresher(const SpotifyAPI::TokenRefresher& refresher) {
+    tokenRefresher_ = refresher;
+
+    if (spotify_api_) {
+        spotify_api_->setTokenRefresher(refresher);
+    }
+}
+
 void TrackOverlay::paintEvent(QPaintEvent *event) {
+    // The progress timer repaints all through playback; that alone is no reason to rewrite the dump
+    ScopedSpan span("paint", false);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const qreal dpr = devicePixelRatioF();
+    if (background_.isNull() || background_.devicePixelRatio() != dpr ||
+        background_.deviceIndependentSize().toSize() != size()) {
+        renderBackground();
+    }
+
     QPainter painter(this);
+    for (const QRect &damaged : event->region()) {
+        const QRectF source(damaged.x() * dpr, damaged.y() * dpr,
+                            damaged.width() * dpr, damaged.height() * dpr);
+        painter.drawPixmap(QRectF(damaged), background_, source);
+        paintStats_.pixels += static_cast<quint64>(damaged.width()) * damaged.height();
+    }
+
+    if (mode_ == OverlayMode::COMPACT) {
+        painter.setClipRegion(event->region());
+        paintCompact(painter);
+    }
+    paintProgress(painter);
+
+    ++paintStats_.paints;
+    if (event->rect() == rect()) {
+        ++paintStats_.fullPaints;
+    }
+    paintStats_.totalNanos += timer.nsecsElapsed();
+}
+
+void TrackOverlay::mousePressEvent(QMouseEvent *event) {
+    wake();
+
+    if (mode_ == OverlayMode::COMPACT && event->button() == Qt::LeftButton) {
+        pressedButton_ = compactButtonAt(event->position().toPoint());
+    }
+
+    QWidget::mousePressEvent(event);
+}
+
+void TrackOverlay::mouseReleaseEvent(QMouseEvent *event) {
+    if (mode_ == OverlayMode::COMPACT && event->button() == Qt::LeftButton) {
+        const int button = compactButtonAt(event->position().toPoint());
+        if (button >= 0 && button == pressedButton_) {
+            triggerAction(CompactButtons[button].action);
+        }
+        pressedButton_ = -1;
+    }
+
+    QWidget::mouseReleaseEvent(event);
+}
+
+void TrackOverlay::enterEvent(QEnterEvent *event) {
+    wake();
+    QWidget::enterEvent(event);
+}
+
+void TrackOverlay::showEvent(QShowEvent *event) {
+    if (spotify_api_) {
+        spotify_api_->resumePolling();
+    }
+    scheduleProgressTimer();
+    advanceProgress();
+
+    QWidget::showEvent(event);
+}
+
+void TrackOverlay::hideEvent(QHideEvent *event) {
+    if (spotify_api_) {
+        spotify_api_->suspendPolling();
+    }
+    progressTimer_->stop();
+
+    QWidget::hideEvent(event);
+}
+
+void TrackOverlay::wake() {
+    if (spotify_api_) {
+        spotify_api_->resumePolling();
+    }
+}
+
+void TrackOverlay::showArt(const QPixmap& pixmap) {
+    if (mode_ == OverlayMode::WIDGETS) {
+        albumArtLabel->setPixmap(pixmap);
+        return;
+    }
+
+    compactArt_ = pixmap;
+    update(CompactArtRect);
+}
+
+void TrackOverlay::showText(const QString& trackText, const QString& artistText) {
+    if (mode_ == OverlayMode::WIDGETS) {
+        trackLabel->setText(trackText);
+        artistLabel->setText(artistText);
+        return;
+    }
+
+    const int width = CompactTextRect.width();
+
+    compactTrack_.setText(QFontMetrics(trackFont_).elidedText(trackText, Qt::ElideRight, width));
+    compactTrack_.prepare(QTransform(), trackFont_);
+
+    compactArtist_.setText(QFontMetrics(artistFont_).elidedText(artistText, Qt::ElideRight, width));
+    compactArtist_.prepare(QTransform(), artistFont_);
+
+    update(CompactTextRect);
+}
+
+void TrackOverlay::showPlayState(bool playing) {
+    if (mode_ == OverlayMode::WIDGETS) {
+        playPause->setText(playing ? "⏸" : "▶");
+        return;
+    }
+
+    update(CompactButtons[1].rect);
+}
+
+void TrackOverlay::showControls() {
+    if (mode_ == OverlayMode::WIDGETS) {
+        playPause->setHidden(false);
+        nextTrack->setHidden(false);
+        backTrack->setHidden(false);
+        return;
+    }
+
+    update(CompactControlsRect);
+}
+
+void TrackOverlay::paintCompact(QPainter& painter) const {
+    painter.drawPixmap(CompactArtRect, compactArt_);
+
+    painter.setPen(Qt::white);
+    painter.setFont(trackFont_);
+    painter.drawStaticText(CompactTextRect.x(), CompactTextRect.y() + 4, compactTrack_);
+
+    painter.setPen(QColor(0xb0, 0xb0, 0xb0));
+    painter.setFont(artistFont_);
+    painter.drawStaticText(CompactTextRect.x(), CompactTextRect.y() + 26, compactArtist_);
+
+    if (!display_.controlsVisible) {
+        return;
+    }
+
+    painter.setPen(Qt::white);
+    painter.setFont(buttonFont_);
+    painter.drawText(CompactButtons[0].rect, Qt::AlignCenter, "⏴");
+    painter.drawText(CompactButtons[1].rect, Qt::AlignCenter, display_.isPlaying ? "⏸" : "▶");
+    painter.drawText(CompactButtons[2].rect, Qt::AlignCenter, "⏵");
+}
+
+int TrackOverlay::compactButtonAt(const QPoint& pos) const {
+    if (!display_.controlsVisible) {
+        return -1;
+    }
+
+    for (int i = 0; i < static_cast<int>(std::size(CompactButtons)); ++i) {
+        if (CompactButtons[i].rect.contains(pos)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void TrackOverlay::triggerAction(PlayBackAction action) const {
+    if (spotify_api_) {
+        spotify_api_->controlPlayback(action, nullptr);
+    }
+}
+
+void TrackOverlay::resyncProgress(const SpotifyTrack& track) {
+    const auto now = std::chrono::steady_clock::now();
+
+    if (track.durationMs != progress_.durationMs) {
+        progress_.pixels = -1;
+    }
+
+    progress_.anchorMs = track.progressMs;
+    progress_.anchorAt = track.fetchedAt.time_since_epoch().count() != 0 ? track.fetchedAt : now;
+    progress_.durationMs = track.durationMs;
+    progress_.playing = track.isPlaying;
+
+    scheduleProgressTimer();
+    advanceProgress();
+}
+
+void TrackOverlay::scheduleProgressTimer() {
+    if (isVisible() && progress_.playing && progress_.durationMs > 0) {
+        // One tick per device pixel the bar grows, bounded to keep redraws cheap
+        const qreal pixels = ProgressRect.width() * devicePixelRatioF();
+        progressTimer_->start(std::clamp(qRound(progress_.durationMs / pixels), 16, 1000));
+    } else {
+        progressTimer_->stop();
+    }
+}
+
+void TrackOverlay::advanceProgress() {
+    const int pixels = progressPixels();
+    if (pixels == progress_.pixels) {
+        return;
+    }
+
+    if (progress_.pixels < 0 || progress_.durationMs <= 0) {
+        update(ProgressRect);
+    } else {
+        const qreal dpr = devicePixelRatioF();
+        const int from = qFloor(std::min(pixels, progress_.pixels) / dpr);
+        const int to = qCeil(std::max(pixels, progress_.pixels) / dpr);
+        update(QRect(ProgressRect.x() + from, ProgressRect.y(), to - from + 1, ProgressRect.height()));
+    }
+    progress_.pixels = pixels;
+
+    if (progress_.durationMs > 0 &&
+        pixels >= qRound(ProgressRect.width() * devicePixelRatioF())) {
+        progressTimer_->stop();
+    }
+}
+
+int TrackOverlay::progressPixels() const {
+    if (progress_.durationMs <= 0) {
+        return 0;
+    }
+
+    qint64 position = progress_.anchorMs;
+    if (progress_.playing) {
+        position += std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - progress_.anchorAt).count();
+    }
+    position = std::clamp<qint64>(position, 0, progress_.durationMs);
+
+    const qint64 width = qRound(ProgressRect.width() * devicePixelRatioF());
+    return static_cast<int>(position * width / progress_.durationMs);
+}
+
+void TrackOverlay::paintProgress(QPainter& painter) const {
+    if (progress_.durationMs <= 0) {
+        return;
+    }
+
+    painter.fillRect(ProgressRect, QColor(60, 60, 60));
+
+    const qreal filled = std::max(progress_.pixels, 0) / devicePixelRatioF();
+    painter.fillRect(QRectF(ProgressRect.x(), ProgressRect.y(), filled, ProgressRect.height()),
+                     QColor(200, 200, 200));
+}
+
+void TrackOverlay::renderBackground() {
+    const qreal dpr = devicePixelRatioF();
+
+    background_ = QPixmap(size() * dpr);
+    background_.setDevicePixelRatio(dpr);
+    background_.fill(palette().color(QPalette::Window));
+
+    QPainter painter(&background_);
+    painter.setRenderHint(QPainter::Antialiasing);
 
     QPainterPath path;
     path.addRoundedRect(rect(), 12, 12);
     painter.fillPath(path, QColor(20, 20, 20));
 
-    QWidget::paintEvent(event);
+    ++paintStats_.layerRenders;
 }
 
 void TrackOverlay::onImageDownloaded(QNetworkReply* reply) {
-    std::cout << "Image download completed" << std::endl;
-
-    if (reply->error() == QNetworkReply::NoError) {
-        QByteArray imageData = reply->readAll();
+    ScopedSpan span("image_downloaded");
 
-        QPixmap albumArt;
-        if (albumArt.loadFromData(imageData)) {
-            QPixmap roundedArt(64, 64);
-            roundedArt.fill(Qt::transparent);
+    const QString url = reply->request().attribute(QNetworkRequest::User).toString();
+    const bool prefetch = reply->request().attribute(PrefetchAttribute).toBool();
+    const quint64 generation = reply->property("artGeneration").toULongLong();
 
-            QPainter painter(&roundedArt);
-            painter.setRenderHint(QPainter::Antialiasing);
+    pendingArt_.remove(url);
+    if (reply == artReply_) {
+        artReply_ = nullptr;
+    }
 
-            QPainterPath path;
-            path.addRoundedRect(0, 0, 64, 64, 8, 8);
-            painter.setClipPath(path);
+    if (reply->error() == QNetworkReply::OperationCanceledError) {
+        ++artFetchStats_.cancelled;
+    } else if (reply->error() == QNetworkReply::NoError) {
+        const QByteArray imageData = reply->readAll();
+        ++artFetchStats_.completed;
 
-            QPixmap scaledArt = albumArt.scaled(64, 64, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-            painter.drawPixmap(0, 0, scaledArt);
+        if (prefetch) {
+            prefetchBytes_ += imageData.size();
+        }
 
-            albumArtLabel->setPixmap(roundedArt);
-            std::cout << "Album art loaded and scaled successfully" << std::endl;
-        } else {
-            std::cerr << "Failed to load image from downloaded data" << std::endl;
-            albumArtLabel->setPixmap(getDefaultAlbumArt());
+        const bool current = generation == 0 || generation == artGeneration_;
+        if (!current) {
+            ++artFetchStats_.stale;
         }
+        artPipeline_->store(url, imageData, 64, devicePixelRatioF(), current);
     } else {
-        std::cerr << "Failed to download album art: " << reply->errorString().toStdString() << std::endl;
-        albumArtLabel->setPixmap(getDefaultAlbumArt());
+        ++artFetchStats_.failed;
+        Log::stream(LogLevel::WARN) << "Failed to download album art: " << reply->errorString().toStdString() << std::endl;
+        if (generation == artGeneration_) {
+            showArt(getDefaultAlbumArt());
+        }
     }
 
     reply->deleteLater();
 }
 
+void TrackOverlay::onAlbumArtMissed(const QString& url, bool prefetch) {
+    diskLookups_.remove(url);
+
+    // A prefetch lookup may have become the current cover while it was on the worker
+    if (url == currentArtUrl_) {
+        downloadAlbumArt(url, false);
+        artReply_ = pendingArt_.value(url);
+        if (artReply_) {
+            artReply_->setProperty("artGeneration", artGeneration_);
+        }
+    } else if (prefetch) {
+        downloadAlbumArt(url, true);
+    }
+}
+
+void TrackOverlay::downloadAlbumArt(const QString& url, bool prefetch) {
+    if (pendingArt_.contains(url)) return;
+
+    if (prefetch && prefetchBytes_ >= prefetchConfig_.maxBytesPerHour) {
+        Log::stream(LogLevel::INFO) << "Album art prefetch budget exhausted" << std::endl;
+        return;
+    }
+
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::User, url);
+    if (prefetch) {
+        request.setAttribute(PrefetchAttribute, true);
+        request.setPriority(QNetworkRequest::LowPriority);
+    }
+    pendingArt_.insert(url, networkManager->get(request));
+    ++artFetchStats_.started;
+}
+
+void TrackOverlay::onAlbumArtRendered(const QString& url, const QImage& image) {
+    diskLookups_.remove(url);
+
+    if (image.isNull()) {
+        Log::stream(LogLevel::ERROR) << "Failed to load image from downloaded data" << std::endl;
+        if (url == currentArtUrl_) {
+            showArt(getDefaultAlbumArt());
+        }
+        return;
+    }
+
+    const QPixmap roundedArt = QPixmap::fromImage(image);
+    artCache_.insertPixmap(url, roundedArt);
+
+    if (url == currentArtUrl_) {
+        showArt(roundedArt);
+        if (Log::enabled(LogLevel::DEBUG)) {
+            Log::stream(LogLevel::DEBUG) << "Album art loaded and scaled successfully" << std::endl;
+        }
+    }
+}
+
+void TrackOverlay::prefetchAlbumArt(const std::vector<SpotifyTrack>& tracks) {
+    if (!prefetchWindow_.isValid() || prefetchWindow_.hasExpired(60 * 60 * 1000)) {
+        prefetchWindow_.start();
+        prefetchBytes_ = 0;
+    }
+
+    for (const auto& track : tracks) {
+        const QString url = QString::fromStdString(track.imageUrl);
+
+        if (url.isEmpty() || url == currentArtUrl_ || pendingArt_.contains(url) ||
+            diskLookups_.contains(url) || artCache_.containsPixmap(url, devicePixelRatioF())) {
+            continue;
+        }
+
+        // The disk cache is checked on the pipeline worker; a miss downloads it
+        diskLookups_.insert(url);
+        artPipeline_->load(url, 64, devicePixelRatioF(), true);
+    }
+}
+
 void TrackOverlay::setDefaultStyles() const {
     albumArtLabel->setStyleSheet(R"(
         QLabel {
@@ -367,18 +803,45 @@ void TrackOverlay::setDefaultStyles() const {
 
 void TrackOverlay::loadAlbumArt(const std::string& imageUrl) {
     QString url = QString::fromStdString(imageUrl);
+    currentArtUrl_ = url;
+    ++artGeneration_;
 
-    if (!url.isEmpty()) {
-        QNetworkRequest request(url);
-        request.setAttribute(QNetworkRequest::User, url);
-        networkManager->get(request);
-    } else {
-        albumArtLabel->setPixmap(getDefaultAlbumArt());
+    if (artReply_ && artReply_->request().attribute(QNetworkRequest::User).toString() != url) {
+        artReply_->abort();
+    }
+
+    if (url.isEmpty()) {
+        showArt(getDefaultAlbumArt());
+        return;
+    }
+
+    QPixmap cached;
+    if (artCache_.findPixmap(url, devicePixelRatioF(), cached)) {
+        showArt(cached);
+        return;
+    }
+
+    if (QNetworkReply *pending = pendingArt_.value(url)) {
+        artReply_ = pending;
+        artReply_->setProperty("artGeneration", artGeneration_);
+        return;
+    }
+
+    // onAlbumArtRendered or onAlbumArtMissed picks this up once the disk has been checked
+    if (!diskLookups_.contains(url)) {
+        diskLookups_.insert(url);
+        artPipeline_->load(url, 64, devicePixelRatioF(), false);
     }
 }
 
 QPixmap TrackOverlay::getDefaultAlbumArt() {
-    QPixmap defaultArt(64, 64);
+    const qreal dpr = devicePixelRatioF();
+    if (!defaultArt_.isNull() && defaultArt_.devicePixelRatio() == dpr) {
+        return defaultArt_;
+    }
+
+    QPixmap defaultArt(QSize(64, 64) * dpr);
+    defaultArt.setDevicePixelRatio(dpr);
     defaultArt.fill(Qt::transparent);
 
     QPainter painter(&defaultArt);
@@ -396,7 +859,10 @@ QPixmap TrackOverlay::getDefaultAlbumArt() {
     QFont font = painter.font();
     font.setPointSize(20);
     painter.setFont(font);
-    painter.drawText(defaultArt.rect(), Qt::AlignCenter, "♪");
+    painter.drawText(QRect(0, 0, 64, 64), Qt::AlignCenter, "♪");
+    painter.end();
 
-    return defaultArt;
+    defaultArt_ = defaultArt;
+    ++paintStats_.layerRenders;
+    return defaultArt_;
 }
@@ -0,0 +1,223 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/TrackParser.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+
+TrackParser::TrackParser() {
+    path_.reserve(16);
+    images_.reserve(4);
+}
+
+bool TrackParser::parseCurrentlyPlaying(const std::string& body, SpotifyTrack& track, int minImageSize) {
+    reset(Mode::CURRENTLY_PLAYING, minImageSize);
+    track_ = &track;
+
+    const bool ok = nlohmann::json::sax_parse(body, this);
+
+    track_ = nullptr;
+    return ok;
+}
+
+bool TrackParser::parseQueue(const std::string& body, std::vector<SpotifyTrack>& tracks, size_t limit, int minImageSize) {
+    reset(Mode::QUEUE, minImageSize);
+    tracks.clear();
+    queue_ = &tracks;
+    queueLimit_ = limit;
+
+    const bool ok = nlohmann::json::sax_parse(body, this);
+
+    track_ = nullptr;
+    queue_ = nullptr;
+    return ok;
+}
+
+bool TrackParser::null() {
+    return true;
+}
+
+bool TrackParser::boolean(bool value) {
+    if (inRoot() && key_ == Field::IS_PLAYING) {
+        track_->isPlaying = value;
+    }
+    return true;
+}
+
+bool TrackParser::number_integer(int64_t value) {
+    return integer(value);
+}
+
+bool TrackParser::number_unsigned(uint64_t value) {
+    return integer(static_cast<int64_t>(value));
+}
+
+bool TrackParser::number_float(double, const std::string&) {
+    return true;
+}
+
+bool TrackParser::string(std::string& value) {
+    if (inItem()) {
+        if (key_ == Field::ID) track_->id.assign(value);
+        else if (key_ == Field::NAME) track_->name.assign(value);
+    } else if (inArtist() && key_ == Field::NAME) {
+        if (!track_->artist.empty()) track_->artist.append(", ");
+        track_->artist.append(value);
+    } else if (inImage() && key_ == Field::URL) {
+        image_.url.assign(value);
+    }
+    return true;
+}
+
+bool TrackParser::binary(std::vector<uint8_t>&) {
+    return true;
+}
+
+bool TrackParser::start_object(std::size_t) {
+    return push(false);
+}
+
+bool TrackParser::end_object() {
+    if (inImage()) {
+        images_.push_back(image_);
+    } else if (inItem()) {
+        if (const AlbumImage* image = selectImage()) {
+            track_->imageUrl = image->url;
+        }
+        if (mode_ == Mode::QUEUE) {
+            track_ = nullptr;
+        }
+    }
+
+    path_.pop_back();
+    key_ = Field::OTHER;
+    return true;
+}
+
+bool TrackParser::start_array(std::size_t) {
+    return push(true);
+}
+
+bool TrackParser::end_array() {
+    path_.pop_back();
+    key_ = Field::OTHER;
+    return true;
+}
+
+bool TrackParser::key(std::string& value) {
+    if (value == "is_playing") key_ = Field::IS_PLAYING;
+    else if (value == "progress_ms") key_ = Field::PROGRESS_MS;
+    else if (value == "timestamp") key_ = Field::TIMESTAMP;
+    else if (value == "item") key_ = Field::ITEM;
+    else if (value == "queue") key_ = Field::QUEUE;
+    else if (value == "id") key_ = Field::ID;
+    else if (value == "name") key_ = Field::NAME;
+    else if (value == "duration_ms") key_ = Field::DURATION_MS;
+    else if (value == "artists") key_ = Field::ARTISTS;
+    else if (value == "album") key_ = Field::ALBUM;
+    else if (value == "images") key_ = Field::IMAGES;
+    else if (value == "url") key_ = Field::URL;
+    else if (value == "width") key_ = Field::WIDTH;
+    else if (value == "height") key_ = Field::HEIGHT;
+    else key_ = Field::OTHER;
+    return true;
+}
+
+void TrackParser::reset(Mode mode, int minImageSize) {
+    mode_ = mode;
+    minImageSize_ = minImageSize;
+    path_.clear();
+    images_.clear();
+    key_ = Field::OTHER;
+}
+
+const AlbumImage* TrackParser::selectImage() const {
+    // Smallest variant that still covers the target, otherwise the largest one
+    const AlbumImage* best = nullptr;
+    const AlbumImage* largest = nullptr;
+
+    for (const auto& image : images_) {
+        const int side = std::min(image.width, image.height);
+
+        if (!largest || side > std::min(largest->width, largest->height)) {
+            largest = &image;
+        }
+        if (side >= minImageSize_ && (!best || side < std::min(best->width, best->height))) {
+            best = &image;
+        }
+    }
+
+    return best ? best : largest;
+}
+
+bool TrackParser::push(bool array) {
+    Field field = key_;
+    if (path_.empty()) {
+        field = Field::ROOT;
+    } else if (path_.back().array) {
+        field = Field::ELEMENT;
+    }
+
+    path_.push_back(Frame{field, array});
+    key_ = Field::OTHER;
+
+    if (mode_ == Mode::QUEUE && !array && path_.size() == 3 &&
+        path_[1].field == Field::QUEUE && path_[2].field == Field::ELEMENT) {
+        if (queue_->size() < queueLimit_) {
+            track_ = &queue_->emplace_back();
+            images_.clear();
+        }
+    }
+
+    if (inImage()) {
+        image_.url.clear();
+        image_.width = 0;
+        image_.height = 0;
+    }
+    return true;
+}
+
+bool TrackParser::integer(int64_t value) {
+    if (inRoot() && key_ == Field::PROGRESS_MS) {
+        track_->progressMs = static_cast<int>(value);
+    } else if (inRoot() && key_ == Field::TIMESTAMP) {
+        track_->timestamp = value;
+    } else if (inItem() && key_ == Field::DURATION_MS) {
+        track_->durationMs = static_cast<int>(value);
+    } else if (inImage()) {
+        if (key_ == Field::WIDTH) image_.width = static_cast<int>(value);
+        else if (key_ == Field::HEIGHT) image_.height = static_cast<int>(value);
+    }
+    return true;
+}
+
+size_t TrackParser::trackDepth() const {
+    if (!track_) return 0;
+
+    if (mode_ == Mode::CURRENTLY_PLAYING) {
+        return path_.size() >= 2 && path_[1].field == Field::ITEM ? 2 : 0;
+    }
+    return path_.size() >= 3 && path_[1].field == Field::QUEUE && path_[2].field == Field::ELEMENT ? 3 : 0;
+}
+
+bool TrackParser::inRoot() const {
+    return mode_ == Mode::CURRENTLY_PLAYING && track_ && path_.size() == 1;
+}
+
+bool TrackParser::inItem() const {
+    const size_t depth = trackDepth();
+    return depth != 0 && path_.size() == depth;
+}
+
+bool TrackParser::inArtist() const {
+    const size_t depth = trackDepth();
+    return depth != 0 && path_.size() == depth + 2 &&
+           path_[depth].field == Field::ARTISTS && path_[depth + 1].field == Field::ELEMENT;
+}
+
+bool TrackParser::inImage() const {
+    const size_t depth = trackDepth();
+    return depth != 0 && path_.size() == depth + 3 && path_[depth].field == Field::ALBUM &&
+           path_[depth + 1].field == Field::IMAGES && path_[depth + 2].field == Field::ELEMENT;
+}
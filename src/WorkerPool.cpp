@@ -0,0 +1,173 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+#include "../include/WorkerPool.h"
+#include "../include/Log.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    int rank(TaskKind kind) {
+        switch (kind) {
+            case TaskKind::COMMAND: return 0;
+            case TaskKind::POLL: return 1;
+            case TaskKind::PREFETCH: return 2;
+        }
+        return 2;
+    }
+}
+
+WorkerPool::WorkerPool(size_t threadCount, size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1))
+{
+    resize(threadCount, capacity_);
+}
+
+void WorkerPool::resize(size_t threadCount, size_t capacity) {
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+
+        capacity_ = std::max<size_t>(capacity, 1);
+        targetThreads_ = std::max<size_t>(threadCount, 1);
+
+        // Threads retired by an earlier shrink have already left workerLoop
+        for (const auto id : retired_) {
+            const auto it = std::find_if(threads_.begin(), threads_.end(),
+                                         [id](const std::thread& thread) { return thread.get_id() == id; });
+            if (it != threads_.end()) {
+                finished.push_back(std::move(*it));
+                threads_.erase(it);
+            }
+        }
+        retired_.clear();
+
+        // Surplus threads retire on their own the next time they look for work
+        while (liveThreads_ < targetThreads_) {
+            threads_.emplace_back([this]() { workerLoop(); });
+            ++liveThreads_;
+        }
+    }
+
+    cv_.notify_all();
+
+    for (auto& thread : finished) {
+        thread.join();
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+SubmitResult WorkerPool::submit(Task task, TaskKind kind) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return SubmitResult::FULL;
+
+        const auto sameKind = [kind](const Entry& entry) { return entry.kind == kind; };
+
+        if (kind != TaskKind::COMMAND && std::any_of(queue_.begin(), queue_.end(), sameKind)) {
+            ++stats_.dropped;
+            return SubmitResult::DUPLICATE;
+        }
+
+        if (queue_.size() >= capacity_) {
+            auto stale = queue_.end();
+            for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+                if (rank(it->kind) > rank(kind) && (stale == queue_.end() || rank(it->kind) > rank(stale->kind))) {
+                    stale = it;
+                }
+            }
+
+            if (stale != queue_.end()) {
+                queue_.erase(stale);
+                ++stats_.dropped;
+            } else {
+                if (kind == TaskKind::COMMAND) {
+                    ++stats_.rejected;
+                } else {
+                    ++stats_.dropped;
+                }
+                Log::stream(LogLevel::WARN) << "Worker queue full, task not accepted" << std::endl;
+                return SubmitResult::FULL;
+            }
+        }
+
+        queue_.push_back(Entry{std::move(task), kind});
+        ++stats_.submitted;
+        stats_.peakQueued = std::max(stats_.peakQueued, queue_.size());
+    }
+
+    cv_.notify_one();
+    return SubmitResult::QUEUED;
+}
+
+void WorkerPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+        queue_.clear();
+    }
+
+    cv_.notify_all();
+
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+WorkerPoolStats WorkerPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WorkerPoolStats stats = stats_;
+    stats.queued = queue_.size();
+    return stats;
+}
+
+bool WorkerPool::takeNext(Entry& out) {
+    auto pick = queue_.end();
+    for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+        if (pick == queue_.end() || rank(it->kind) < rank(pick->kind)) {
+            pick = it;
+        }
+    }
+
+    if (pick == queue_.end()) return false;
+
+    out = std::move(*pick);
+    queue_.erase(pick);
+    return true;
+}
+
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stopping_) {
+        if (liveThreads_ > targetThreads_) {
+            --liveThreads_;
+            retired_.push_back(std::this_thread::get_id());
+            return;
+        }
+
+        Entry entry;
+        if (!takeNext(entry)) {
+            cv_.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        try {
+            entry.task();
+        } catch (const std::exception& e) {
+            Log::stream(LogLevel::ERROR) << "Error in worker task: " << e.what() << std::endl;
+        }
+        lock.lock();
+
+        ++stats_.completed;
+    }
+}
@@ -2,78 +2,181 @@
 // Created by karpen on 11/5/25.
 //
 
-#include <QTimer>
+#include <QSocketNotifier>
 #include <iostream>
+#include <memory>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include "TrackOverlay.h"
 #include "AuthManager.h"
 #include "ConfigManager.h"
+#include "Metrics.h"
+#include "DebugHud.h"
+#include "Log.h"
+
+namespace {
+    int wakeFds[2] = {-1, -1};
+
+    // SIGUSR1 wakes a suspended overlay; the handler only pokes the event loop
+    void onWakeSignal(int) {
+        const char byte = 1;
+        [[maybe_unused]] const auto written = ::write(wakeFds[1], &byte, 1);
+    }
+
+    void installWakeSignal(TrackOverlay& overlay) {
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, wakeFds) != 0) {
+            Log::stream(LogLevel::WARN) << "Failed to create wake socket, SIGUSR1 disabled" << std::endl;
+            return;
+        }
+
+        struct sigaction action {};
+        action.sa_handler = onWakeSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        sigaction(SIGUSR1, &action, nullptr);
+
+        auto *notifier = new QSocketNotifier(wakeFds[0], QSocketNotifier::Read, &overlay);
+        QObject::connect(notifier, &QSocketNotifier::activated, &overlay, [&overlay]() {
+            char byte;
+            [[maybe_unused]] const auto received = ::read(wakeFds[0], &byte, 1);
+            overlay.wake();
+        });
+    }
+
+    void startSession(TrackOverlay& overlay, AuthManager& authManager) {
+        overlay.setAccessToken(authManager.getTokens().accessToken);
+
+        // Refreshed tokens are handed to the API on the GUI thread; a 401 refreshes inline
+        authManager.setAuthCallback([&overlay](const AuthTokens& refreshed) {
+            QMetaObject::invokeMethod(&overlay, [&overlay, token = refreshed.accessToken]() {
+                overlay.setAccessToken(token);
+            }, Qt::QueuedConnection);
+        });
+        overlay.setTokenRefresher([&authManager](const std::string& rejected) {
+            return authManager.refreshNow(rejected);
+        });
+        authManager.startAutoRefresh();
+
+        overlay.startPolling(ConfigManager::getInstance().getPerformanceSettings().polling);
+
+        Log::stream(LogLevel::INFO) << "Spotify initialization completed" << std::endl;
+    }
+
+    void showAuthState(TrackOverlay& overlay, AuthManager& authManager, AuthState state, const std::string& detail) {
+        switch (state) {
+            case AuthState::IDLE:
+                break;
+            case AuthState::AWAITING_BROWSER:
+                Log::stream(LogLevel::INFO) << "Not authenticated, waiting for browser login..." << std::endl;
+                overlay.updateTrackInfo(SpotifyTrack("Sign in to Spotify", "Continue in your browser"));
+                break;
+            case AuthState::EXCHANGING:
+                overlay.updateTrackInfo(SpotifyTrack("Signing in...", detail));
+                break;
+            case AuthState::AUTHENTICATED:
+                Log::stream(LogLevel::INFO) << "Authentication successful!" << std::endl;
+                startSession(overlay, authManager);
+                break;
+            case AuthState::FAILED:
+                Log::stream(LogLevel::ERROR) << "Authentication failed: " << detail << std::endl;
+                overlay.updateTrackInfo(SpotifyTrack("Auth Failed", "Check credentials"));
+                break;
+        }
+    }
+}
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
-    std::cout << "Starting Spotify Overlay..." << std::endl;
+    Log::stream(LogLevel::INFO) << "Starting Spotify Overlay..." << std::endl;
+
+    const auto mode = QApplication::arguments().contains("--compact")
+        ? OverlayMode::COMPACT : OverlayMode::WIDGETS;
 
-    TrackOverlay overlay;
-    std::cout << "Overlay created" << std::endl;
+    // Only reset once the overlay's API client can no longer call back into it
+    std::unique_ptr<AuthManager> authManager;
+
+    TrackOverlay overlay(nullptr, mode);
+    Log::stream(LogLevel::INFO) << "Overlay created" << std::endl;
 
     overlay.setAttribute(Qt::WA_QuitOnClose, true);
+    installWakeSignal(overlay);
 
     overlay.show();
-    std::cout << "Overlay shown" << std::endl;
+    Log::stream(LogLevel::INFO) << "Overlay shown" << std::endl;
+
+    DebugHud hud;
+    if (QApplication::arguments().contains("--hud")) {
+        hud.move(overlay.x(), overlay.y() + overlay.height() + 8);
+        hud.show();
+    }
 
     auto& config = ConfigManager::getInstance();
+
+    // Every exit stops the background threads while the overlay they post to still exists
+    const auto runEventLoop = [&app, &config, &overlay, &authManager]() {
+        const int result = app.exec();
+
+        config.stopWatching();
+        overlay.stopPolling();
+        // Waits out a refresh a worker may be running; none can start once it is cleared
+        overlay.setTokenRefresher(nullptr);
+        authManager.reset();
+        return result;
+    };
+
     if(!config.loadConfig()) {
-        std::cerr << "Error: Failed to load configuration!" << std::endl;
+        Log::stream(LogLevel::ERROR) << "Error: Failed to load configuration!" << std::endl;
 
         SpotifyTrack errorTrack;
         errorTrack.name = "Configuration Error";
         errorTrack.artist = "Check config.ini";
         overlay.updateTrackInfo(errorTrack);
 
-        return app.exec();
+        return runEventLoop();
     }
 
-    std::cout << "Configuration loaded" << std::endl;
+    Log::stream(LogLevel::INFO) << "Configuration loaded" << std::endl;
 
-    QTimer::singleShot(100, [&overlay]() {
-        std::cout << "Starting Spotify initialization..." << std::endl;
+    Log::setLevel(config.getPerformanceSettings().logLevel);
+    overlay.applySettings(config.getPerformanceSettings());
 
-        try {
-            auto& config = ConfigManager::getInstance();
-            AuthManager authManager(config.getClientId(), config.getClientSecret());
+    // Edits to config.ini are applied without a restart
+    config.addSettingsListener([&overlay](const PerformanceSettings& settings) {
+        Log::setLevel(settings.logLevel);
+        QMetaObject::invokeMethod(&overlay, [&overlay, settings]() {
+            overlay.applySettings(settings);
+        }, Qt::QueuedConnection);
+    });
+    config.startWatching();
 
-            if(!authManager.isAuthenticated()) {
-                std::cout << "Not authenticated, starting authentication..." << std::endl;
-                if(!authManager.authenticate()) {
-                    std::cerr << "Authentication failed!" << std::endl;
+    Metrics::getInstance().startDumping("metrics.prom", std::chrono::seconds(15));
 
-                    SpotifyTrack authError;
-                    authError.name = "Auth Failed";
-                    authError.artist = "Check credentials";
-                    overlay.updateTrackInfo(authError);
-                    return;
-                }
-                std::cout << "Authentication successful!" << std::endl;
-            } else {
-                std::cout << "Already authenticated" << std::endl;
-            }
+    try {
+        authManager = std::make_unique<AuthManager>(config.getClientId(), config.getClientSecret(),
+                                                    config.getAccountsBaseUrl());
+    } catch (const std::exception& e) {
+        Log::stream(LogLevel::ERROR) << "Exception during Spotify init: " << e.what() << std::endl;
+        return runEventLoop();
+    }
 
-            const auto& tokens = authManager.getTokens();
-            overlay.setAccessToken(tokens.accessToken);
-            overlay.startPolling(3);
+    // Auth runs on its own thread; state changes are replayed on the GUI thread
+    authManager->setStateCallback([&overlay, &authManager](AuthState state, const std::string& detail) {
+        QMetaObject::invokeMethod(&overlay, [&overlay, &authManager, state, detail]() {
+            showAuthState(overlay, *authManager, state, detail);
+        }, Qt::QueuedConnection);
+    });
 
-            std::cout << "Spotify initialization completed" << std::endl;
+    Log::stream(LogLevel::INFO) << "Starting Spotify initialization..." << std::endl;
+    authManager->authenticateAsync();
 
-        } catch (const std::exception& e) {
-            std::cerr << "Exception during Spotify init: " << e.what() << std::endl;
-        }
-    });
+    Log::stream(LogLevel::INFO) << "Starting application event loop..." << std::endl;
+    const int result = runEventLoop();
 
-    std::cout << "Starting application event loop..." << std::endl;
-    int result = app.exec();
-    std::cout << "Application event loop finished with code: " << result << std::endl;
+    Log::stream(LogLevel::INFO) << "Application event loop finished with code: " << result << std::endl;
 
     return result;
 }
\ No newline at end of file
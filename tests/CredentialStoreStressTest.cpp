@@ -0,0 +1,79 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+// Reader threads hammer current() while a writer keeps publishing tokens, the
+// way workers read the credential while a 401 refresh replaces it. Build with
+// -DSPOTIFYOVERLAY_TSAN=ON to have ThreadSanitizer catch a snapshot freed under
+// a reader.
+
+#include "../include/CredentialStore.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int kReaders = 8;
+    constexpr int kPublishes = 5000;
+
+    std::atomic<int> failures{0};
+
+    void expect(bool condition, const std::string& what) {
+        if (!condition) {
+            std::cerr << "FAILED: " << what << std::endl;
+            ++failures;
+        }
+    }
+}
+
+int main() {
+    CredentialStore store;
+    store.publish("0");
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < kReaders; ++i) {
+        readers.emplace_back([&store, &done]() {
+            int last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const Credential credential = store.current();
+                if (credential.generation == 0) {
+                    expect(false, "a published credential is never empty");
+                    return;
+                }
+
+                const int seen = std::stoi(credential.token);
+                if (credential.authorization != "Bearer " + credential.token ||
+                    credential.generation != static_cast<uint64_t>(seen) + 1 || seen < last) {
+                    expect(false, "reader sees a torn or older snapshot: " + credential.token);
+                    return;
+                }
+                last = seen;
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    // Both sides yield so readers and the writer interleave even on a single core
+    for (int i = 1; i <= kPublishes; ++i) {
+        store.publish(std::to_string(i));
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    const Credential latest = store.current();
+    expect(latest.token == std::to_string(kPublishes), "the last publish wins");
+
+    if (failures == 0) {
+        std::cout << "CredentialStoreStressTest passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+// A PLAY command carries a JSON body. The listener rejects the first attempt
+// with 401; SpotifyAPI must refresh the token and replay the same method,
+// path and body with the new Authorization header, without blocking a worker.
+
+#include "../include/SpotifyAPI.h"
+#include <cpprest/http_listener.h>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace web;
+using namespace web::http;
+using namespace web::http::experimental::listener;
+
+namespace {
+    struct Received {
+        std::string method;
+        std::string authorization;
+        std::string body;
+    };
+
+    int failures = 0;
+
+    void expect(bool condition, const std::string& what) {
+        if (!condition) {
+            std::cerr << "FAILED: " << what << std::endl;
+            ++failures;
+        }
+    }
+}
+
+int main() {
+    std::mutex mutex;
+    std::vector<Received> plays;
+
+    http_listener listener(uri_builder("http://127.0.0.1").set_port(8901).to_uri());
+    listener.support([&](const http_request& request) {
+        const std::string path = request.relative_uri().path();
+
+        if (path != "/v1/me/player/play") {
+            // Warm-up and the refresh that follows a successful command
+            request.reply(request.method() == methods::HEAD ? status_codes::OK : status_codes::NoContent);
+            return;
+        }
+
+        const auto authorization = request.headers().find("Authorization");
+        Received received{request.method(),
+                          authorization != request.headers().end() ? authorization->second : "",
+                          request.extract_utf8string(true).get()};
+
+        bool accepted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            plays.push_back(received);
+            accepted = received.authorization == "Bearer fresh";
+        }
+        request.reply(accepted ? status_codes::NoContent : status_codes::Unauthorized);
+    });
+    listener.open().wait();
+
+    std::condition_variable done;
+    std::vector<bool> results;
+
+    {
+        SpotifyAPI api("http://127.0.0.1:8901/v1");
+        api.setAccessToken("stale");
+        api.setTokenRefresher([](const std::string&) { return std::string("fresh"); });
+
+        const auto play = [&]() {
+            api.controlPlayback(PlayBackAction::PLAY, [&](bool success) {
+                std::lock_guard<std::mutex> lock(mutex);
+                results.push_back(success);
+                done.notify_all();
+            });
+        };
+        const auto waitFor = [&](size_t count) {
+            std::unique_lock<std::mutex> lock(mutex);
+            return done.wait_for(lock, std::chrono::seconds(10), [&]() { return results.size() == count; });
+        };
+
+        play();
+        expect(waitFor(1), "the rejected command completes within 10 s");
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            expect(plays.size() == 2, "the rejected command is sent exactly twice");
+            if (plays.size() == 2) {
+                expect(plays[0].authorization == "Bearer stale", "first attempt uses the old token");
+                expect(plays[1].authorization == "Bearer fresh", "replay uses the refreshed token");
+                expect(plays[1].method == plays[0].method, "replay keeps the method");
+                expect(!plays[0].body.empty() && plays[1].body == plays[0].body, "replay keeps the body");
+            }
+        }
+
+        // More commands with a body than there are workers; none of them may stall a worker
+        for (int i = 0; i < 3; ++i) {
+            play();
+        }
+        expect(waitFor(4), "later commands complete within 10 s");
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const bool success : results) {
+            expect(success, "command succeeds");
+        }
+    }
+
+    listener.close().wait();
+
+    if (failures == 0) {
+        std::cout << "SpotifyAPIReplayTest passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
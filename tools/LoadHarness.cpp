@@ -0,0 +1,204 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+// Drives the real SpotifyAPI against MockSpotifyServer and reports poll
+// latency, CPU, thread count and how long each scripted track change took to
+// reach the track callback.
+
+#include "../include/SpotifyAPI.h"
+#include "../include/Metrics.h"
+#include <cpprest/http_client.h>
+#include <nlohmann/json.hpp>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace web::http;
+using namespace web::http::client;
+
+namespace {
+    struct Options {
+        std::string server = "http://127.0.0.1:8900";
+        int clients = 1;
+        int seconds = 120;
+        PollingConfig polling;
+    };
+
+    struct Observation {
+        std::string id;
+        int64_t seenAtMs;
+    };
+
+    int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    double cpuSeconds() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+               static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    int threadCount() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("Threads:", 0) == 0) return std::atoi(line.c_str() + 8);
+        }
+        return 0;
+    }
+
+    std::string fetchToken(const std::string& server) {
+        http_client client(server);
+        http_request request(methods::POST);
+        request.set_request_uri("/api/token");
+        request.set_body("grant_type=refresh_token&refresh_token=mock-refresh", "application/x-www-form-urlencoded");
+
+        const auto response = client.request(request).get();
+        if (response.status_code() != status_codes::OK) return "";
+        return nlohmann::json::parse(response.extract_utf8string(true).get()).value("access_token", "");
+    }
+
+    nlohmann::json fetchHistory(const std::string& server) {
+        http_client client(server);
+        const auto response = client.request(methods::GET, "/mock/history").get();
+        return nlohmann::json::parse(response.extract_utf8string(true).get());
+    }
+
+    int64_t percentile(std::vector<int64_t> values, double fraction) {
+        if (values.empty()) return 0;
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())))];
+    }
+
+    bool parseOptions(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string flag = argv[i];
+            if (flag == "--help" || i + 1 >= argc) return false;
+
+            const std::string value = argv[++i];
+            if (flag == "--server") options.server = value;
+            else if (flag == "--clients") options.clients = std::max(std::atoi(value.c_str()), 1);
+            else if (flag == "--seconds") options.seconds = std::max(std::atoi(value.c_str()), 1);
+            else if (flag == "--max-interval-ms") options.polling.maxInterval = std::chrono::milliseconds(std::atoi(value.c_str()));
+            else if (flag == "--min-interval-ms") options.polling.minInterval = std::chrono::milliseconds(std::atoi(value.c_str()));
+            else return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--server URL] [--clients N] [--seconds S]\n"
+                  << "       [--min-interval-ms MS] [--max-interval-ms MS]" << std::endl;
+        return 2;
+    }
+
+    const std::string token = fetchToken(options.server);
+    if (token.empty()) {
+        std::cerr << "Mock server at " << options.server << " did not issue a token" << std::endl;
+        return 1;
+    }
+
+    std::mutex observedMutex;
+    std::vector<std::vector<Observation>> observed(static_cast<size_t>(options.clients));
+    std::atomic<uint64_t> errors{0};
+
+    const int baselineThreads = threadCount();
+    const double cpuBefore = cpuSeconds();
+    const auto startedAt = std::chrono::steady_clock::now();
+
+    std::vector<std::unique_ptr<SpotifyAPI>> clients;
+    for (int i = 0; i < options.clients; ++i) {
+        auto api = std::make_unique<SpotifyAPI>(options.server + "/v1");
+        api->setAccessToken(token);
+        api->setTokenRefresher([server = options.server](const std::string&) { return fetchToken(server); });
+        api->setErrorCallback([&errors](const std::string&) { ++errors; });
+        api->setTrackCallback([&observedMutex, &observed, i](const SpotifyTrack& track, const TrackChanges& changes) {
+            if (!changes.track) return;
+            std::lock_guard<std::mutex> lock(observedMutex);
+            observed[static_cast<size_t>(i)].push_back(Observation{track.id, nowMs()});
+        });
+        api->startPolling(options.polling);
+        clients.push_back(std::move(api));
+    }
+
+    int peakThreads = 0;
+    int64_t threadSamples = 0;
+    int64_t threadSum = 0;
+    while (std::chrono::steady_clock::now() - startedAt < std::chrono::seconds(options.seconds)) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const int threads = threadCount();
+        peakThreads = std::max(peakThreads, threads);
+        threadSum += threads;
+        ++threadSamples;
+    }
+
+    for (const auto& api : clients) {
+        api->stopPolling();
+    }
+
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+    const double cpu = cpuSeconds() - cpuBefore;
+
+    // Match each server-side change with the first callback that showed it
+    const auto history = fetchHistory(options.server);
+    std::vector<int64_t> delays;
+    int missed = 0;
+    {
+        std::lock_guard<std::mutex> lock(observedMutex);
+        for (size_t i = 1; i < history.size(); ++i) {
+            const auto id = history[i]["id"].get<std::string>();
+            const auto changedAt = history[i]["changed_at_ms"].get<int64_t>();
+            const int64_t nextChangeAt = i + 1 < history.size()
+                ? history[i + 1]["changed_at_ms"].get<int64_t>() : std::numeric_limits<int64_t>::max();
+
+            for (const auto& seen : observed) {
+                const auto match = std::find_if(seen.begin(), seen.end(), [&](const Observation& observation) {
+                    return observation.id == id && observation.seenAtMs >= changedAt && observation.seenAtMs < nextChangeAt;
+                });
+                if (match != seen.end()) {
+                    delays.push_back(match->seenAtMs - changedAt);
+                } else if (changedAt < nowMs() - options.polling.maxInterval.count()) {
+                    ++missed;
+                }
+            }
+        }
+    }
+
+    const SpanStats poll = Metrics::getInstance().requestStats("/me/player/currently-playing");
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "clients:            " << options.clients << " for " << wall << " s" << std::endl;
+    std::cout << "polls:              " << poll.count << " (" << poll.count / wall << "/s), "
+              << errors << " errors" << std::endl;
+    std::cout << "poll latency:       p50 " << poll.p50Micros / 1000.0 << " ms, p99 " << poll.p99Micros / 1000.0
+              << " ms, max " << poll.maxMicros / 1000.0 << " ms" << std::endl;
+    std::cout << "cpu:                " << cpu << " s (" << 100.0 * cpu / wall << "% of one core)" << std::endl;
+    std::cout << "threads:            baseline " << baselineThreads << ", mean "
+              << (threadSamples ? static_cast<double>(threadSum) / static_cast<double>(threadSamples) : 0.0)
+              << ", peak " << peakThreads << std::endl;
+    std::cout << "change detection:   " << delays.size() << " seen, " << missed << " missed, p50 "
+              << percentile(delays, 0.5) << " ms, p90 " << percentile(delays, 0.9) << " ms, max "
+              << percentile(delays, 1.0) << " ms" << std::endl;
+
+    clients.clear();
+    return 0;
+}
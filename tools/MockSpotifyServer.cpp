@@ -0,0 +1,375 @@
+//
+// Created by karpen on 10/16/26.
+//
+
+// Local stand-in for the Spotify Web API and accounts service, for offline
+// load runs. Serves the player endpoints under /v1 and the token endpoints at
+// the root, plays a scripted list of tracks back to back and can inject
+// latency, 429s, 5xx and 401s. /mock/history lists every track change with
+// the time it happened, so a harness can measure detection delay.
+
+#include <cpprest/http_listener.h>
+#include <cpprest/uri.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace web;
+using namespace web::http;
+using namespace web::http::experimental::listener;
+
+namespace {
+    struct Options {
+        int port = 8900;
+        std::vector<int> trackMs{30000};
+        int tracks = 20;
+        int latencyMs = 0;
+        int jitterMs = 0;
+        double rate429 = 0;
+        int retryAfter = 2;
+        double rate5xx = 0;
+        double rate401 = 0;
+        int tokenTtl = 3600;
+        unsigned seed = 1;
+    };
+
+    struct Change {
+        std::string id;
+        int64_t changedAtMs;
+    };
+
+    int64_t epochMs(std::chrono::system_clock::time_point at) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(at.time_since_epoch()).count();
+    }
+
+    class MockSpotify {
+    public:
+        explicit MockSpotify(const Options& options)
+            : options_(options),
+              random_(options.seed),
+              startedAt_(std::chrono::system_clock::now()) {
+            history_.push_back(Change{trackId(0), epochMs(startedAt_)});
+        }
+
+        void handle(const http_request& request) {
+            const std::string path = request.relative_uri().path();
+
+            if (path.rfind("/v1/", 0) == 0) {
+                handleApi(request, path.substr(3));
+            } else if (path == "/api/token" && request.method() == methods::POST) {
+                reply(request, status_codes::OK, issueToken());
+            } else if (path == "/authorize") {
+                authorize(request);
+            } else if (path == "/mock/history") {
+                reply(request, status_codes::OK, history());
+            } else if (path == "/mock/next" && request.method() == methods::POST) {
+                skip(1);
+                request.reply(status_codes::NoContent);
+            } else if (request.method() == methods::HEAD) {
+                request.reply(status_codes::OK);
+            } else {
+                request.reply(status_codes::NotFound);
+            }
+        }
+
+    private:
+        Options options_;
+        std::mutex mutex_;
+        std::mt19937 random_;
+
+        int index_ = 0;
+        bool playing_ = true;
+        int pausedAtMs_ = 0;
+        std::chrono::system_clock::time_point startedAt_;
+        std::vector<Change> history_;
+
+        std::map<std::string, std::chrono::system_clock::time_point> tokens_;
+        uint64_t issued_ = 0;
+
+        std::string trackId(int index) const {
+            std::ostringstream id;
+            id << "mocktrack" << (index % options_.tracks);
+            return id.str();
+        }
+
+        int durationOf(int index) const {
+            return options_.trackMs[static_cast<size_t>(index) % options_.trackMs.size()];
+        }
+
+        // Plays through finished tracks so changes land exactly at track boundaries
+        void advance(std::chrono::system_clock::time_point now) {
+            if (!playing_) return;
+
+            while (now - startedAt_ >= std::chrono::milliseconds(durationOf(index_))) {
+                startedAt_ += std::chrono::milliseconds(durationOf(index_));
+                ++index_;
+                history_.push_back(Change{trackId(index_), epochMs(startedAt_)});
+            }
+        }
+
+        int progressMs(std::chrono::system_clock::time_point now) const {
+            if (!playing_) return pausedAtMs_;
+            return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - startedAt_).count());
+        }
+
+        void skip(int delta) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto now = std::chrono::system_clock::now();
+            advance(now);
+
+            index_ = std::max(index_ + delta, 0);
+            startedAt_ = now;
+            pausedAtMs_ = 0;
+            history_.push_back(Change{trackId(index_), epochMs(now)});
+        }
+
+        nlohmann::json trackJson(int index) const {
+            const std::string id = trackId(index);
+            const int number = index % options_.tracks;
+
+            nlohmann::json images = nlohmann::json::array();
+            for (const int size : {640, 300, 64}) {
+                images.push_back({{"url", "http://127.0.0.1:" + std::to_string(options_.port) + "/art/" + id + "_" +
+                                          std::to_string(size) + ".jpg"},
+                                  {"width", size}, {"height", size}});
+            }
+
+            return {
+                {"id", id},
+                {"name", "Mock Track " + std::to_string(number)},
+                {"duration_ms", durationOf(index)},
+                {"type", "track"},
+                {"uri", "spotify:track:" + id},
+                {"artists", nlohmann::json::array({{{"id", "mockartist" + std::to_string(number % 5)},
+                                                    {"name", "Mock Artist " + std::to_string(number % 5)}}})},
+                {"album", {{"id", "mockalbum" + std::to_string(number)},
+                           {"name", "Mock Album " + std::to_string(number)},
+                           {"images", images}}}
+            };
+        }
+
+        void handleApi(const http_request& request, const std::string& path) {
+            if (const int delay = injectedLatency(); delay > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+            }
+
+            if (const auto fault = injectedFault(request)) {
+                http_response response(fault);
+                if (fault == status_codes::TooManyRequests) {
+                    response.headers().add("Retry-After", std::to_string(options_.retryAfter));
+                }
+                request.reply(response);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto now = std::chrono::system_clock::now();
+            advance(now);
+
+            if (path == "/me/player/currently-playing" && request.method() == methods::GET) {
+                const nlohmann::json body = {
+                    {"timestamp", epochMs(now)},
+                    {"progress_ms", progressMs(now)},
+                    {"is_playing", playing_},
+                    {"currently_playing_type", "track"},
+                    {"item", trackJson(index_)}
+                };
+                reply(request, status_codes::OK, body);
+            } else if (path == "/me/player/queue" && request.method() == methods::GET) {
+                nlohmann::json queue = nlohmann::json::array();
+                for (int i = 1; i <= 10; ++i) queue.push_back(trackJson(index_ + i));
+                reply(request, status_codes::OK, {{"currently_playing", trackJson(index_)}, {"queue", queue}});
+            } else if (path == "/me/player/play" && request.method() == methods::PUT) {
+                if (!playing_) {
+                    startedAt_ = now - std::chrono::milliseconds(pausedAtMs_);
+                    playing_ = true;
+                }
+                request.reply(status_codes::NoContent);
+            } else if (path == "/me/player/pause" && request.method() == methods::PUT) {
+                if (playing_) {
+                    pausedAtMs_ = progressMs(now);
+                    playing_ = false;
+                }
+                request.reply(status_codes::NoContent);
+            } else if ((path == "/me/player/next" || path == "/me/player/previous") && request.method() == methods::POST) {
+                index_ = std::max(index_ + (path == "/me/player/next" ? 1 : -1), 0);
+                startedAt_ = now;
+                pausedAtMs_ = 0;
+                history_.push_back(Change{trackId(index_), epochMs(now)});
+                request.reply(status_codes::NoContent);
+            } else if (path == "/me/player/seek" && request.method() == methods::PUT) {
+                const auto query = uri::split_query(request.request_uri().query());
+                const auto position = query.find("position_ms");
+                const int positionMs = position != query.end() ? std::atoi(position->second.c_str()) : 0;
+                startedAt_ = now - std::chrono::milliseconds(positionMs);
+                pausedAtMs_ = positionMs;
+                request.reply(status_codes::NoContent);
+            } else if (path == "/me/player/volume" && request.method() == methods::PUT) {
+                request.reply(status_codes::NoContent);
+            } else {
+                request.reply(status_codes::NotFound);
+            }
+        }
+
+        int injectedLatency() {
+            if (options_.latencyMs <= 0 && options_.jitterMs <= 0) return 0;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::uniform_int_distribution<int> jitter(0, std::max(options_.jitterMs, 0));
+            return options_.latencyMs + jitter(random_);
+        }
+
+        status_code injectedFault(const http_request& request) {
+            const auto authorization = request.headers().find("Authorization");
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (authorization == request.headers().end() || !tokenValid(authorization->second)) {
+                return status_codes::Unauthorized;
+            }
+
+            std::uniform_real_distribution<double> roll(0.0, 1.0);
+            if (roll(random_) < options_.rate429) return status_codes::TooManyRequests;
+            if (roll(random_) < options_.rate5xx) return status_codes::ServiceUnavailable;
+            if (roll(random_) < options_.rate401) {
+                // Revoke the token so the client has to refresh, as with a real expiry
+                tokens_.erase(authorization->second.substr(7));
+                return status_codes::Unauthorized;
+            }
+            return 0;
+        }
+
+        bool tokenValid(const std::string& authorization) const {
+            if (authorization.rfind("Bearer ", 0) != 0) return false;
+
+            const auto token = tokens_.find(authorization.substr(7));
+            return token != tokens_.end() && std::chrono::system_clock::now() < token->second;
+        }
+
+        nlohmann::json issueToken() {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            const std::string token = "mock-access-" + std::to_string(++issued_);
+            tokens_[token] = std::chrono::system_clock::now() + std::chrono::seconds(options_.tokenTtl);
+
+            return {
+                {"access_token", token},
+                {"token_type", "Bearer"},
+                {"expires_in", options_.tokenTtl},
+                {"refresh_token", "mock-refresh"},
+                {"scope", "user-read-currently-playing user-read-playback-state user-modify-playback-state"}
+            };
+        }
+
+        // Skips the browser: redirects straight back with a code
+        static void authorize(const http_request& request) {
+            const auto query = uri::split_query(request.request_uri().query());
+            const auto redirect = query.find("redirect_uri");
+            if (redirect == query.end()) {
+                request.reply(status_codes::BadRequest);
+                return;
+            }
+
+            http_response response(status_codes::Found);
+            response.headers().add("Location", uri::decode(redirect->second) + "?code=mock-code");
+            request.reply(response);
+        }
+
+        nlohmann::json history() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            advance(std::chrono::system_clock::now());
+
+            nlohmann::json changes = nlohmann::json::array();
+            for (const auto& change : history_) {
+                changes.push_back({{"id", change.id}, {"changed_at_ms", change.changedAtMs}});
+            }
+            return changes;
+        }
+
+        static void reply(const http_request& request, status_code code, const nlohmann::json& body) {
+            http_response response(code);
+            response.set_body(body.dump(), "application/json");
+            request.reply(response);
+        }
+    };
+
+    std::vector<int> parseList(const std::string& value) {
+        std::vector<int> values;
+        std::stringstream stream(value);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            values.push_back(std::max(std::atoi(item.c_str()), 1000));
+        }
+        return values.empty() ? std::vector<int>{30000} : values;
+    }
+
+    bool parseOptions(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string flag = argv[i];
+            if (flag == "--help" || i + 1 >= argc) return false;
+
+            const std::string value = argv[++i];
+            if (flag == "--port") options.port = std::atoi(value.c_str());
+            else if (flag == "--track-ms") options.trackMs = parseList(value);
+            else if (flag == "--tracks") options.tracks = std::max(std::atoi(value.c_str()), 1);
+            else if (flag == "--latency-ms") options.latencyMs = std::atoi(value.c_str());
+            else if (flag == "--jitter-ms") options.jitterMs = std::atoi(value.c_str());
+            else if (flag == "--rate-429") options.rate429 = std::atof(value.c_str());
+            else if (flag == "--retry-after") options.retryAfter = std::max(std::atoi(value.c_str()), 1);
+            else if (flag == "--rate-5xx") options.rate5xx = std::atof(value.c_str());
+            else if (flag == "--rate-401") options.rate401 = std::atof(value.c_str());
+            else if (flag == "--token-ttl") options.tokenTtl = std::max(std::atoi(value.c_str()), 1);
+            else if (flag == "--seed") options.seed = static_cast<unsigned>(std::atoi(value.c_str()));
+            else return false;
+        }
+        return true;
+    }
+
+    volatile std::sig_atomic_t stopRequested = 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--port N] [--track-ms MS[,MS...]] [--tracks N]\n"
+                  << "       [--latency-ms MS] [--jitter-ms MS] [--rate-429 P] [--retry-after S]\n"
+                  << "       [--rate-5xx P] [--rate-401 P] [--token-ttl S] [--seed N]" << std::endl;
+        return 2;
+    }
+
+    MockSpotify mock(options);
+
+    http_listener listener(uri_builder("http://127.0.0.1").set_port(options.port).to_uri());
+    listener.support([&mock](const http_request& request) {
+        mock.handle(request);
+    });
+
+    try {
+        listener.open().wait();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to listen on port " << options.port << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, [](int) { stopRequested = 1; });
+    std::signal(SIGTERM, [](int) { stopRequested = 1; });
+
+    std::cout << "Mock Spotify listening on http://127.0.0.1:" << options.port
+              << " (api.base_url = http://127.0.0.1:" << options.port << "/v1)" << std::endl;
+
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    listener.close().wait();
+    return 0;
+}